@@ -0,0 +1,180 @@
+//
+// Created by tal.shaked3 on 12/01/2020.
+//
+
+#include "BitImage.h"
+#include <cstring>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define BITIMAGE_AVX2
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/**
+ * @brief constructor, of an image with all its cells blank
+ * @param rows - the number of rows
+ * @param cols - the number of cols
+ */
+BitImage::BitImage(size_t rows, size_t cols) :
+        _rows(rows), _cols(cols), _wordsInRow((cols + WORDBITS - 1) / WORDBITS),
+        _bits(rows * _wordsInRow, 0)
+{
+}
+
+#ifndef __SSE2__
+
+/**
+ * @brief the chars of every byte value, as expandRow writes them
+ */
+struct ByteChars
+{
+    char table[256][8];
+
+    ByteChars() : table()
+    {
+        for (int byte = 0; byte < 256; byte++)
+        {
+            for (int bit = 0; bit < 8; bit++)
+            {
+                table[byte][bit] = ((byte >> bit) & 1) ? FILL : BLANK;
+            }
+        }
+    }
+};
+
+/**
+ * @brief expands whole words of cells to chars through a lookup table, a byte at a time
+ * @param bits - the words
+ * @param words - the number of words
+ * @param dest - the buffer to write 64 chars per word in to
+ */
+static void expandWordsByTable(const uint64_t *bits, size_t words, char *dest)
+{
+    static const ByteChars chars;
+    for (size_t w = 0; w < words; w++)
+    {
+        for (int byte = 0; byte < 8; byte++)
+        {
+            unsigned int value = (bits[w] >> (byte * 8)) & 0xff;
+            memcpy(dest + w * WORDBITS + byte * 8, chars.table[value], 8);
+        }
+    }
+}
+
+#else
+
+/**
+ * @brief expands whole words of cells to chars with sse2, 16 cells at a time. every byte of
+ * the word is spread over the 8 bytes of its cells, and each of them keeps only its own bit.
+ * @param bits - the words
+ * @param words - the number of words
+ * @param dest - the buffer to write 64 chars per word in to
+ */
+static void expandWordsSse2(const uint64_t *bits, size_t words, char *dest)
+{
+    const __m128i select = _mm_set1_epi64x((long long) 0x8040201008040201ull);
+    const __m128i blank = _mm_set1_epi8(BLANK);
+    const __m128i flip = _mm_set1_epi8(FILL ^ BLANK);
+    for (size_t w = 0; w < words; w++)
+    {
+        __m128i word = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(&bits[w]));
+        __m128i twice = _mm_unpacklo_epi8(word, word);
+        __m128i low = _mm_unpacklo_epi16(twice, twice);
+        __m128i high = _mm_unpackhi_epi16(twice, twice);
+        __m128i cells[4] = {_mm_unpacklo_epi32(low, low), _mm_unpackhi_epi32(low, low),
+                            _mm_unpacklo_epi32(high, high), _mm_unpackhi_epi32(high, high)};
+        for (int i = 0; i < 4; i++)
+        {
+            __m128i set = _mm_cmpeq_epi8(_mm_and_si128(cells[i], select), select);
+            __m128i out = _mm_xor_si128(blank, _mm_and_si128(set, flip));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dest + w * WORDBITS + i * 16), out);
+        }
+    }
+}
+
+#endif
+
+#ifdef BITIMAGE_AVX2
+
+/**
+ * @brief expands whole words of cells to chars with avx2, 32 cells at a time. see
+ * expandWordsSse2
+ * @param bits - the words
+ * @param words - the number of words
+ * @param dest - the buffer to write 64 chars per word in to
+ */
+__attribute__((target("avx2")))
+static void expandWordsAvx2(const uint64_t *bits, size_t words, char *dest)
+{
+    const __m256i select = _mm256_set1_epi64x((long long) 0x8040201008040201ull);
+    const __m256i spread = _mm256_setr_epi8(0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1,
+                                            2, 2, 2, 2, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 3, 3);
+    const __m256i blank = _mm256_set1_epi8(BLANK);
+    const __m256i flip = _mm256_set1_epi8(FILL ^ BLANK);
+    for (size_t w = 0; w < words; w++)
+    {
+        for (int half = 0; half < 2; half++)
+        {
+            __m256i four = _mm256_set1_epi32((int) (uint32_t) (bits[w] >> (half * 32)));
+            __m256i cells = _mm256_shuffle_epi8(four, spread);
+            __m256i set = _mm256_cmpeq_epi8(_mm256_and_si256(cells, select), select);
+            __m256i out = _mm256_xor_si256(blank, _mm256_and_si256(set, flip));
+            char *to = dest + w * WORDBITS + half * 32;
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(to), out);
+        }
+    }
+}
+
+#endif
+
+/**
+ * @return the fastest way to expand words this cpu supports
+ */
+static void (*chooseExpandWords())(const uint64_t *, size_t, char *)
+{
+#ifdef BITIMAGE_AVX2
+    if (__builtin_cpu_supports("avx2"))
+    {
+        return expandWordsAvx2;
+    }
+#endif
+#ifdef __SSE2__
+    return expandWordsSse2;
+#else
+    return expandWordsByTable;
+#endif
+}
+
+/**
+ * @brief writes a row of bits as chars, FILL for a set bit and BLANK for a clear one. whole
+ * words are expanded with the widest simd the cpu has (chosen once, at run time), and the
+ * cells of the last partial word one by one.
+ * @param bits - the words of the row
+ * @param cols - the number of cells in the row
+ * @param dest - the buffer to write the cols chars in to
+ */
+void BitImage::expandRow(const uint64_t *bits, size_t cols, char *dest)
+{
+    static void (*const expandWords)(const uint64_t *, size_t, char *) = chooseExpandWords();
+    size_t words = cols / WORDBITS;
+    expandWords(bits, words, dest);
+    for (size_t col = words * WORDBITS; col < cols; col++)
+    {
+        dest[col] = ((bits[col / WORDBITS] >> (col % WORDBITS)) & 1u) ? FILL : BLANK;
+    }
+}
+
+/**
+ * @return the image as chars, row after row
+ */
+std::vector<char> BitImage::toChars() const
+{
+    std::vector<char> chars(_rows * _cols);
+    for (size_t r = 0; r < _rows; r++)
+    {
+        expandRow(row(r), _cols, &chars[r * _cols]);
+    }
+    return chars;
+}
@@ -0,0 +1,107 @@
+//
+// Created by tal.shaked3 on 12/01/2020.
+//
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+#ifndef UNTITLED_BITIMAGE_H
+#define UNTITLED_BITIMAGE_H
+
+#define FILL '#'
+#define BLANK ' '
+#define WORDBITS 64
+
+/**
+ * @brief a black and white image, packed as a bit per cell. every row starts at a new word of
+ * 64 cells, where cell c of the row is bit c % 64 of word c / 64 (a set bit is filled). the
+ * bits after the last col of a row are always clear.
+ */
+class BitImage
+{
+private:
+    size_t _rows;
+    size_t _cols;
+    size_t _wordsInRow;
+    std::vector<uint64_t> _bits;
+
+public:
+    /**
+     * @brief constructor, of an image with all its cells blank
+     * @param rows - the number of rows
+     * @param cols - the number of cols
+     */
+    BitImage(size_t rows, size_t cols);
+
+    /**
+     * @return the number of rows in the image
+     */
+    size_t getRows() const
+    {
+        return _rows;
+    }
+
+    /**
+     * @return the number of cols in the image
+     */
+    size_t getCols() const
+    {
+        return _cols;
+    }
+
+    /**
+     * @return the number of words every row takes
+     */
+    size_t getWordsInRow() const
+    {
+        return _wordsInRow;
+    }
+
+    /**
+     * @param row - the index of a row
+     * @return the words of the row
+     */
+    uint64_t *row(size_t row)
+    {
+        return _bits.data() + row * _wordsInRow;
+    }
+
+    const uint64_t *row(size_t row) const
+    {
+        return _bits.data() + row * _wordsInRow;
+    }
+
+    /**
+     * @return true if the cell is filled, false otherwise
+     */
+    bool get(size_t row, size_t col) const
+    {
+        return (this->row(row)[col / WORDBITS] >> (col % WORDBITS)) & 1u;
+    }
+
+    /**
+     * @brief fills or blanks a cell
+     */
+    void set(size_t row, size_t col, bool fill)
+    {
+        uint64_t bit = (uint64_t) 1 << (col % WORDBITS);
+        uint64_t &word = this->row(row)[col / WORDBITS];
+        word = fill ? (word | bit) : (word & ~bit);
+    }
+
+    /**
+     * @brief writes a row of bits as chars, FILL for a set bit and BLANK for a clear one. the
+     * bits are expanded a byte (8 cells) at a time through a lookup table.
+     * @param bits - the words of the row
+     * @param cols - the number of cells in the row
+     * @param dest - the buffer to write the cols chars in to
+     */
+    static void expandRow(const uint64_t *bits, size_t cols, char *dest);
+
+    /**
+     * @return the image as chars, row after row
+     */
+    std::vector<char> toChars() const;
+};
+
+#endif //UNTITLED_BITIMAGE_H
@@ -5,10 +5,14 @@
 #include "Fractal.h"
 #include <iostream>
 #include <vector>
-#include <cmath>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+#include <unistd.h>
 
-#define FILL '#'
-#define BLANK ' '
+#define TILESIZE 64 // a multiple of WORDBITS, so that tiles never share a word
 
 /**
  * @brief - default constructor defined virtual so that inheriting classes would be
@@ -22,23 +26,364 @@ Fractal::Fractal(int l, int i)
 
 /**
  * @brief - draw the fractal out to cout. this function uses checkWhatToFill, and according
- * to it fills in a table (constructed in our case as a vector) with '#' or ' '.
+ * to it fills in a table (constructed in our case as a bit image) with '#' or ' '.
+ * @param numThreads - the number of threads to fill the table with. 0 means one per core.
  */
-void Fractal::draw()
+void Fractal::draw(int numThreads)
 {
+    std::cout.flush();
+    drawTo(STDOUT_FILENO, numThreads);
+}
 
-    double numOfRows = pow(this->getFracSize(), this->getLevel());
-    double numOfCols = numOfRows;
-    std::vector<char> allPic;
-    for (int row = 0; row < numOfRows; row++)
+/**
+ * @brief - draw the fractal out to a file descriptor, in a single bulk write
+ * @param fd - the file descriptor to write to
+ * @param numThreads - the number of threads to fill the table with. 0 means one per core.
+ * @return true if the whole fractal was written, false otherwise
+ */
+bool Fractal::drawTo(int fd, int numThreads) const
+{
+    if (!fitsInMemory())
     {
-        for (int col = 0; col < numOfCols; col++)
+        return stream(fd);
+    }
+    return writeFrac(fd, render(numThreads));
+}
+
+/**
+ * @brief - draw the fractal out to a file descriptor a band of rows at a time, without ever
+ * holding the whole table in memory. the band is as many rows as fit in memoryBudget chars
+ * (at least one), so the memory used doesn't depend on the level of the fractal.
+ * @param fd - the file descriptor to write to
+ * @param memoryBudget - the size of the buffer to build the rows in
+ * @return true if the whole fractal was written, false otherwise
+ */
+bool Fractal::stream(int fd, size_t memoryBudget) const
+{
+    size_t size = getSize();
+    size_t stride = size + 1;
+    size_t bandRows = std::min(size, std::max((size_t) 1, memoryBudget / stride));
+    std::vector<char> band(bandRows * stride);
+    std::vector<uint64_t> masks;
+    std::vector<uint64_t> partial;
+    BitImage bits(0, 0);
+    if (isSelfSimilar())
+    {
+        masks = _digitMasks();
+        bits = BitImage(bandRows, size);
+    }
+    for (size_t first = 0; first < size; first += bandRows)
+    {
+        size_t rows = std::min(bandRows, size - first);
+        if (isSelfSimilar())
+        {
+            _maskRows(first, rows, masks, partial, bits.row(0), bits.getWordsInRow());
+        }
+        for (size_t i = 0; i < rows; i++)
         {
-            char toPut = checkWhatToFill(row, col);
-            allPic.push_back(toPut);
+            char *line = &band[i * stride];
+            if (isSelfSimilar())
+            {
+                BitImage::expandRow(bits.row(i), size, line);
+            }
+            else
+            {
+                for (size_t col = 0; col < size; col++)
+                {
+                    line[col] = checkWhatToFill((int) (first + i), (int) col);
+                }
+            }
+            line[size] = '\n';
+        }
+        if (!writeFrac(fd, band.data(), rows * stride))
+        {
+            return false;
         }
     }
-    printFrac(allPic, numOfRows, numOfCols);
+    return writeFrac(fd, "\n", 1);
+}
+
+/**
+ * @brief renders the fractal as the text it is printed as - every row followed by a '\n',
+ * and another '\n' at the end. the table is built as bits, and only expanded to chars here.
+ * @param numThreads - the number of threads to fill the table with. 0 means one per core.
+ * @return the text of the fractal
+ */
+std::vector<char> Fractal::render(int numThreads) const
+{
+    BitImage image = isSelfSimilar() ? construct(numThreads) : rasterize(numThreads);
+    size_t size = getSize();
+    size_t stride = size + 1;
+    std::vector<char> text(size * stride + 1);
+    for (size_t row = 0; row < size; row++)
+    {
+        BitImage::expandRow(image.row(row), size, &text[row * stride]);
+        text[row * stride + size] = '\n';
+    }
+    text.back() = '\n';
+    return text;
+}
+
+/**
+ * @brief renders a self similar fractal out of the rendered text of a lower level of it:
+ * each level is a getFracSize() x getFracSize() grid of blocks, each block being either
+ * blank or a copy of the level below, so its rows are copied a block at a time. the rows of a
+ * level are shared between the threads, once a level is TILESIZE rows or more.
+ * @param lower - the rendered text of the fractal at a lower level (see render())
+ * @param lowerLevel - the level of lower, no higher than the level of the fractal
+ * @param numThreads - the number of threads to copy the rows with. 0 means one per core.
+ * @return the text of the fractal
+ */
+std::vector<char> Fractal::renderFrom(const std::vector<char> &lower, int lowerLevel,
+                                      int numThreads) const
+{
+    int n = getFracSize();
+    std::vector<char> base = _basePattern();
+    std::vector<char> text = lower;
+    size_t size = 1;
+    for (int level = 0; level < lowerLevel; level++)
+    {
+        size *= n;
+    }
+    for (int level = lowerLevel + 1; level <= getLevel(); level++)
+    {
+        size_t newSize = size * n;
+        std::vector<char> next((newSize + 1) * newSize + 1);
+        _parallelFor((int) newSize, newSize < TILESIZE ? 1 : numThreads, [&](int line)
+        {
+            size_t blockRow = line / size;
+            size_t row = line % size;
+            char *dest = &next[line * (newSize + 1)];
+            for (int blockCol = 0; blockCol < n; blockCol++)
+            {
+                if (base[blockRow * n + blockCol] == FILL)
+                {
+                    memcpy(dest + blockCol * size, &text[row * (size + 1)], size);
+                }
+                else
+                {
+                    memset(dest + blockCol * size, BLANK, size);
+                }
+            }
+            dest[newSize] = '\n';
+        });
+        next.back() = '\n';
+        text.swap(next);
+        size = newSize;
+    }
+    return text;
+}
+
+/**
+ * @brief fills the table of the fractal, using checkWhatToFill per cell. the table is split
+ * into square tiles of TILESIZE cells, and the tiles are shared between the threads, each
+ * filling its own tiles in place. the result doesn't depend on the number of threads.
+ * @param numThreads - the number of threads to fill the table with. 0 means one per core.
+ * @return the table of the fractal
+ */
+BitImage Fractal::rasterize(int numThreads) const
+{
+    size_t size = getSize();
+    BitImage image(size, size);
+    int tilesInRow = (int) ((size + TILESIZE - 1) / TILESIZE);
+    _parallelFor(tilesInRow * tilesInRow, numThreads, [&](int tile)
+    {
+        _fillTile(image, (size_t) (tile / tilesInRow) * TILESIZE,
+                  (size_t) (tile % tilesInRow) * TILESIZE);
+    });
+    return image;
+}
+
+/**
+ * @brief fills one square tile of the fractal table, using checkWhatToFill per cell. a tile
+ * spans whole words of its rows, so tiles never share a word.
+ * @param image - the whole fractal table
+ * @param firstRow - the first row of the tile
+ * @param firstCol - the first col of the tile
+ */
+void Fractal::_fillTile(BitImage &image, size_t firstRow, size_t firstCol) const
+{
+    size_t size = getSize();
+    size_t lastRow = std::min(size, firstRow + TILESIZE);
+    size_t lastCol = std::min(size, firstCol + TILESIZE);
+    for (size_t row = firstRow; row < lastRow; row++)
+    {
+        for (size_t col = firstCol; col < lastCol; col++)
+        {
+            image.set(row, col, checkWhatToFill((int) row, (int) col) == FILL);
+        }
+    }
+}
+
+/**
+ * @brief builds the table of the fractal out of its self similarity: a cell is filled only if
+ * every pair of digits of its row and col (in base getFracSize()) is a filled cell of the base
+ * pattern. so every row is the and of one precomputed mask per digit of the row, done a whole
+ * word (64 cells) at a time. the rows are split to bands that are shared between the threads.
+ * @param numThreads - the number of threads to fill the table with. 0 means one per core.
+ * @return the table of the fractal
+ */
+BitImage Fractal::construct(int numThreads) const
+{
+    size_t size = getSize();
+    BitImage image(size, size);
+    std::vector<uint64_t> masks = _digitMasks();
+    int numOfBands = (int) ((size + TILESIZE - 1) / TILESIZE);
+    _parallelFor(numOfBands, numThreads, [&](int band)
+    {
+        size_t firstRow = (size_t) band * TILESIZE;
+        size_t rows = std::min((size_t) TILESIZE, size - firstRow);
+        std::vector<uint64_t> partial;
+        _maskRows(firstRow, rows, masks, partial, image.row(firstRow), image.getWordsInRow());
+    });
+    return image;
+}
+
+/**
+ * @return the masks of all the digits, for the rows of the table. the mask of digit d (counted
+ * from the least significant) and value v has the bit of every col set if the cell of row v
+ * and of the col's digit d in the base pattern is filled. masks are getSize() bits long, one
+ * after the other, by d and then by v.
+ */
+std::vector<uint64_t> Fractal::_digitMasks() const
+{
+    int n = getFracSize();
+    size_t size = getSize();
+    size_t words = (size + WORDBITS - 1) / WORDBITS;
+    std::vector<char> base = _basePattern();
+    std::vector<uint64_t> masks((size_t) getLevel() * n * words, 0);
+    size_t digitSize = 1;
+    for (int digit = 0; digit < getLevel(); digit++)
+    {
+        for (int value = 0; value < n; value++)
+        {
+            uint64_t *mask = &masks[((size_t) digit * n + value) * words];
+            for (size_t col = 0; col < size; col++)
+            {
+                if (base[value * n + (col / digitSize) % n] == FILL)
+                {
+                    mask[col / WORDBITS] |= (uint64_t) 1 << (col % WORDBITS);
+                }
+            }
+        }
+        digitSize *= n;
+    }
+    return masks;
+}
+
+/**
+ * @brief builds consecutive rows of the table of a self similar fractal, every row as the and
+ * of the masks of its digits. the and of the masks of the higher digits is kept from row to
+ * row and redone only from the highest digit that changed, so a row takes less than two passes
+ * over its words on average, whatever the level is.
+ * @param first - the index of the first row
+ * @param count - the number of rows to build
+ * @param masks - the masks of the digits, see _digitMasks()
+ * @param partial - the ands kept between calls. an empty one starts over, otherwise first
+ * must be the row after the last row it was used for.
+ * @param dest - the words to build the rows in to
+ * @param destStride - the number of words between the starts of two rows in dest
+ */
+void Fractal::_maskRows(size_t first, size_t count, const std::vector<uint64_t> &masks,
+                        std::vector<uint64_t> &partial, uint64_t *dest, size_t destStride) const
+{
+    int n = getFracSize();
+    int level = getLevel();
+    size_t size = getSize();
+    size_t words = (size + WORDBITS - 1) / WORDBITS;
+    // partial[d] is the and of the masks of the digits d and above, partial[level] is all set
+    bool resume = !partial.empty();
+    if (!resume)
+    {
+        partial.assign((size_t) (level + 1) * words, 0);
+        for (size_t col = 0; col < size; col++)
+        {
+            partial[level * words + col / WORDBITS] |= (uint64_t) 1 << (col % WORDBITS);
+        }
+    }
+    std::vector<int> digits(level + 1, 0);
+    for (size_t row = first; row < first + count; row++)
+    {
+        size_t value = row;
+        for (int digit = 0; digit < level; digit++)
+        {
+            digits[digit] = (int) (value % n);
+            value /= n;
+        }
+        // going to the next row only changes the digits up to the lowest one that isn't 0
+        int changed = level - 1;
+        if (row != first || resume)
+        {
+            changed = 0;
+            while (changed < level - 1 && digits[changed] == 0)
+            {
+                changed++;
+            }
+        }
+        for (int digit = changed; digit >= 0; digit--)
+        {
+            const uint64_t *mask = &masks[((size_t) digit * n + digits[digit]) * words];
+            const uint64_t *above = &partial[(digit + 1) * words];
+            uint64_t *out = &partial[digit * words];
+            for (size_t w = 0; w < words; w++)
+            {
+                out[w] = above[w] & mask[w];
+            }
+        }
+        memcpy(dest + (row - first) * destStride, &partial[0], words * sizeof(uint64_t));
+    }
+}
+
+/**
+ * @brief runs count jobs over a number of threads, each thread taking the next job that is
+ * left until there are none
+ * @param count - the number of jobs
+ * @param numThreads - the number of threads. 0 means one per core.
+ * @param job - the job, given its index
+ */
+void Fractal::_parallelFor(int count, int numThreads, const std::function<void(int)> &job)
+{
+    if (numThreads <= 0)
+    {
+        numThreads = std::max(1, (int) std::thread::hardware_concurrency());
+    }
+    numThreads = std::min(numThreads, count);
+
+    std::atomic<int> next(0);
+    auto worker = [&]()
+    {
+        for (int i = next++; i < count; i = next++)
+        {
+            job(i);
+        }
+    };
+    std::vector<std::thread> threads;
+    for (int i = 1; i < numThreads; i++)
+    {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto &t : threads)
+    {
+        t.join();
+    }
+}
+
+/**
+ * @return the table of the fractal of level 1 - its base pattern
+ */
+std::vector<char> Fractal::_basePattern() const
+{
+    int n = getFracSize();
+    std::vector<char> base((size_t) n * n);
+    for (int row = 0; row < n; row++)
+    {
+        for (int col = 0; col < n; col++)
+        {
+            base[row * n + col] = checkWhatToFill(row, col);
+        }
+    }
+    return base;
 }
 
 /**
@@ -48,17 +393,57 @@ void Fractal::draw()
  * @param numOfRows - the number of rows that this vector is supposed to be divided in to.
  * @param numOfCols - the number of cols that this vector is supposed to be divided in to.
  */
-void Fractal::printFrac(std::vector<char> frac, double numOfRows, double numOfCols)
+void Fractal::printFrac(const std::vector<char> &frac, double numOfRows, double numOfCols)
+{
+    auto rows = (size_t) numOfRows;
+    auto cols = (size_t) numOfCols;
+    std::vector<char> text(rows * (cols + 1) + 1);
+    for (size_t row = 0; row < rows; row++)
+    {
+        memcpy(&text[row * (cols + 1)], &frac[row * cols], cols);
+        text[row * (cols + 1) + cols] = '\n';
+    }
+    text.back() = '\n';
+    std::cout.flush();
+    writeFrac(STDOUT_FILENO, text);
+}
+
+/**
+ * @brief writes a rendered fractal (see render()) to a file descriptor, as one bulk write
+ * @param fd - the file descriptor to write to
+ * @param text - the text of the fractal
+ * @return true if all the text was written, false otherwise
+ */
+bool Fractal::writeFrac(int fd, const std::vector<char> &text)
+{
+    return writeFrac(fd, text.data(), text.size());
+}
+
+/**
+ * @brief writes a buffer to a file descriptor, retrying until all of it is written
+ * @param fd - the file descriptor to write to
+ * @param buf - the buffer
+ * @param length - the number of chars to write
+ * @return true if all the buffer was written, false otherwise
+ */
+bool Fractal::writeFrac(int fd, const char *buf, size_t length)
 {
-    for (int i = 0; i < numOfRows * numOfCols; i++)
+    size_t left = length;
+    while (left > 0)
     {
-        std::cout << frac[i];
-        if (i > 0 && i % (int) numOfCols == numOfCols - 1)
+        ssize_t written = write(fd, buf, left);
+        if (written < 0)
         {
-            std::cout << "\n";
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return false;
         }
+        buf += written;
+        left -= written;
     }
-    std::cout << "\n";
+    return true;
 }
 
 /**
@@ -2,6 +2,10 @@
 // Created by tal.shaked3 on 06/01/2020.
 //
 #include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include "BitImage.h"
 
 #ifndef UNTITLED_FRACTAL_H
 #define UNTITLED_FRACTAL_H
@@ -10,6 +14,8 @@
 #define CARPETNUM 3
 #define TRIANGLENUM 2
 #define VICSEKNUM 3
+#define STREAMBUDGET (1 << 24)
+#define STREAMBAND (1 << 20)
 
 /**
  * @brief - an abstract fractal class, consisting of a constructor, a virtual defaultive
@@ -22,6 +28,52 @@ private:
     int _level;
     int _numToDup;
 
+    /**
+     * @brief fills one square tile of the fractal table, using checkWhatToFill per cell. a tile
+     * spans whole words of its rows, so tiles never share a word.
+     * @param image - the whole fractal table
+     * @param firstRow - the first row of the tile
+     * @param firstCol - the first col of the tile
+     */
+    void _fillTile(BitImage &image, size_t firstRow, size_t firstCol) const;
+
+    /**
+     * @return the table of the fractal of level 1 - its base pattern
+     */
+    std::vector<char> _basePattern() const;
+
+    /**
+     * @return the masks of all the digits, for the rows of the table. the mask of digit d
+     * (counted from the least significant) and value v has the bit of every col set if the
+     * cell of row v and of the col's digit d in the base pattern is filled. masks are getSize()
+     * bits long, one after the other, by d and then by v.
+     */
+    std::vector<uint64_t> _digitMasks() const;
+
+    /**
+     * @brief builds consecutive rows of the table of a self similar fractal, every row as the
+     * and of the masks of its digits. the and of the masks of the higher digits is kept from
+     * row to row and redone only from the highest digit that changed, so a row takes less than
+     * two passes over its words on average, whatever the level is.
+     * @param first - the index of the first row
+     * @param count - the number of rows to build
+     * @param masks - the masks of the digits, see _digitMasks()
+     * @param partial - the ands kept between calls. an empty one starts over, otherwise first
+     * must be the row after the last row it was used for.
+     * @param dest - the words to build the rows in to
+     * @param destStride - the number of words between the starts of two rows in dest
+     */
+    void _maskRows(size_t first, size_t count, const std::vector<uint64_t> &masks,
+                   std::vector<uint64_t> &partial, uint64_t *dest, size_t destStride) const;
+
+    /**
+     * @brief runs count jobs over a number of threads, each thread taking the next job that is
+     * left until there are none
+     * @param count - the number of jobs
+     * @param numThreads - the number of threads. 0 means one per core.
+     * @param job - the job, given its index
+     */
+    static void _parallelFor(int count, int numThreads, const std::function<void(int)> &job);
 
 public:
     /**
@@ -39,9 +91,58 @@ public:
 
     /**
      * @brief - draw the fractal out to cout. this function uses checkWhatToFill, and according
-     * to it fills in a table (constructed in our case as a vector) with '#' or ' '.
+     * to it fills in a table (constructed in our case as a bit image) with '#' or ' '.
+     * @param numThreads - the number of threads to fill the table with. 0 means one per core.
+     */
+    void draw(int numThreads = 0);
+
+    /**
+     * @brief - draw the fractal out to a file descriptor, in a single bulk write
+     * @param fd - the file descriptor to write to
+     * @param numThreads - the number of threads to fill the table with. 0 means one per core.
+     * @return true if the whole fractal was written, false otherwise
      */
-    void draw();
+    bool drawTo(int fd, int numThreads = 0) const;
+
+    /**
+     * @brief - draw the fractal out to a file descriptor a band of rows at a time, without ever
+     * holding the whole table in memory. the band is as many rows as fit in memoryBudget chars
+     * (at least one), so the memory used doesn't depend on the level of the fractal.
+     * @param fd - the file descriptor to write to
+     * @param memoryBudget - the size of the buffer to build the rows in
+     * @return true if the whole fractal was written, false otherwise
+     */
+    bool stream(int fd, size_t memoryBudget = STREAMBAND) const;
+
+    /**
+     * @brief renders the fractal as the text it is printed as - every row followed by a '\n',
+     * and another '\n' at the end. the table is built as bits, and only expanded to chars here.
+     * @param numThreads - the number of threads to fill the table with. 0 means one per core.
+     * @return the text of the fractal
+     */
+    std::vector<char> render(int numThreads = 0) const;
+
+    /**
+     * @brief renders a self similar fractal out of the rendered text of a lower level of it:
+     * each level is a getFracSize() x getFracSize() grid of blocks, each block being either
+     * blank or a copy of the level below, so its rows are copied a block at a time. the rows of a
+     * level are shared between the threads, once a level is TILESIZE rows or more.
+     * @param lower - the rendered text of the fractal at a lower level (see render())
+     * @param lowerLevel - the level of lower, no higher than the level of the fractal
+     * @param numThreads - the number of threads to copy the rows with. 0 means one per core.
+     * @return the text of the fractal
+     */
+    std::vector<char> renderFrom(const std::vector<char> &lower, int lowerLevel,
+                                 int numThreads = 0) const;
+
+    /**
+     * @brief fills the table of the fractal, using checkWhatToFill per cell. the table is split
+     * into square tiles of TILESIZE cells, and the tiles are shared between the threads, each
+     * filling its own tiles in place. the result doesn't depend on the number of threads.
+     * @param numThreads - the number of threads to fill the table with. 0 means one per core.
+     * @return the table of the fractal
+     */
+    BitImage rasterize(int numThreads = 0) const;
 
     /**
      * @brief prints a given fractal that already is given as a vector of chars, and the
@@ -50,7 +151,45 @@ public:
      * @param numOfRows - the number of rows that this vector is supposed to be divided in to.
      * @param numOfCols - the number of cols that this vector is supposed to be divided in to.
      */
-    void static printFrac(std::vector<char> frac, double numOfRows, double numOfCols);
+    void static printFrac(const std::vector<char> &frac, double numOfRows, double numOfCols);
+
+    /**
+     * @brief writes a rendered fractal (see render()) to a file descriptor, as one bulk write
+     * @param fd - the file descriptor to write to
+     * @param text - the text of the fractal
+     * @return true if all the text was written, false otherwise
+     */
+    bool static writeFrac(int fd, const std::vector<char> &text);
+
+    /**
+     * @brief writes a buffer to a file descriptor, retrying until all of it is written
+     * @param fd - the file descriptor to write to
+     * @param buf - the buffer
+     * @param length - the number of chars to write
+     * @return true if all the buffer was written, false otherwise
+     */
+    bool static writeFrac(int fd, const char *buf, size_t length);
+
+    /**
+     * @brief builds the table of the fractal out of its self similarity: a cell is filled only
+     * if every pair of digits of its row and col (in base getFracSize()) is a filled cell of
+     * the base pattern. so every row is the and of one precomputed mask per digit of the row,
+     * done a whole word (64 cells) at a time. the rows are split to bands that are shared
+     * between the threads.
+     * @param numThreads - the number of threads to fill the table with. 0 means one per core.
+     * @return the table of the fractal
+     */
+    BitImage construct(int numThreads = 0) const;
+
+    /**
+     * @return true if the fractal is made of copies of itself by its base pattern (the cells
+     * that checkWhatToFill fills in the table of level 1), so that construct() can be used to
+     * draw it. false by default.
+     */
+    virtual bool isSelfSimilar() const
+    {
+        return false;
+    }
 
     /**
      * @brief a virtual function not implemented here
@@ -68,6 +207,29 @@ public:
         return this->_level;
     }
 
+    /**
+     * @return the number of rows (and of cols) in the table of the fractal
+     */
+    size_t getSize() const
+    {
+        size_t size = 1;
+        for (int i = 0; i < _level; i++)
+        {
+            size *= _numToDup;
+        }
+        return size;
+    }
+
+    /**
+     * @return true if the text of the fractal fits in STREAMBUDGET chars, so it can be
+     * rendered in memory as a whole. bigger fractals are streamed.
+     */
+    bool fitsInMemory() const
+    {
+        size_t size = getSize();
+        return size * (size + 1) <= STREAMBUDGET;
+    }
+
     /**
      * @return returns the base multiplier of the fractal (for instance the Vicsek is 3)
      */
@@ -99,6 +261,14 @@ public:
      * @return -' ' or '#'
      */
     char checkWhatToFill(int row, int col) const override;
+
+    /**
+     * @return true, the fractal is self similar
+     */
+    bool isSelfSimilar() const override
+    {
+        return true;
+    }
 };
 
 /**
@@ -122,6 +292,14 @@ public:
      * @return -' ' or '#'
      */
     char checkWhatToFill(int row, int col) const override;
+
+    /**
+     * @return true, the fractal is self similar
+     */
+    bool isSelfSimilar() const override
+    {
+        return true;
+    }
 };
 
 /**
@@ -145,6 +323,14 @@ public:
      * @return -' ' or '#'
      */
     char checkWhatToFill(int row, int col) const override;
+
+    /**
+     * @return true, the fractal is self similar
+     */
+    bool isSelfSimilar() const override
+    {
+        return true;
+    }
 };
 
 #endif //UNTITLED_FRACTAL_H
@@ -1,8 +1,19 @@
 
 #include "Fractal.h"
+#include "RenderCache.h"
 #include<boost/tokenizer.hpp>
 #include <iostream>
 #include <fstream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <algorithm>
+#include <unistd.h>
+
+#define MAXDIM 12
+#define REORDERWINDOW 16
 
 /**
  * @brief checking if to given strings are valid numbers to our program
@@ -15,11 +26,26 @@ bool checkTwoStringAreValidNums(std::string const &a, std::string const &b);
 /**
  * @brief a factory that creates fractals according to the input
  * @param index - a is in {1,2,3}
- * @param dim - 0<b<7
+ * @param dim - 0<b<=MAXDIM
  * @return a pointer to a newly created fractal
  */
 Fractal *fractalD(int index, int dim);
 
+/**
+ * @brief draws fractals to cout in the given order, rendering them concurrently on a pool of
+ * threads. the rendered fractals are written in order through a reorder buffer, which holds at
+ * most REORDERWINDOW of them that are rendered ahead. fractals that don't fit in memory are
+ * streamed by the writer when their turn comes. the rest are taken from a render cache, so a
+ * fractal that repeats is rendered once. every fractal is rendered with an equal share of the
+ * threads, so fewer fractals than threads still keep all of them busy.
+ * @param fractals - the fractals, in the order to draw them
+ * @param types - the type (index) of every fractal
+ * @param cache - the render cache
+ * @param numThreads - the number of rendering threads. 0 means one per core.
+ */
+void drawConcurrently(const std::vector<Fractal *> &fractals, const std::vector<int> &types,
+                      RenderCache &cache, int numThreads);
+
 int main(int argc, char *argv[])
 {
     using namespace std;
@@ -38,6 +64,7 @@ int main(int argc, char *argv[])
     }
     string line;
     vector<Fractal *> vectorOfProccess;
+    vector<int> vectorOfTypes;
     vector<string> vectorOfLine;
     int indexFractal, dimFractal;
     while (getline(inp, line))
@@ -57,6 +84,7 @@ int main(int argc, char *argv[])
             sscanf(vectorOfLine[1].c_str(), "%d", &dimFractal);
             Fractal *curFractal = fractalD(indexFractal, dimFractal);
             vectorOfProccess.push_back(curFractal);
+            vectorOfTypes.push_back(indexFractal);
         }
         else
         {
@@ -65,16 +93,96 @@ int main(int argc, char *argv[])
         }
 
     }
-    Fractal *f;
-    while (!vectorOfProccess.empty())
+    reverse(vectorOfProccess.begin(), vectorOfProccess.end());
+    reverse(vectorOfTypes.begin(), vectorOfTypes.end());
+    RenderCache cache(CACHECAP);
+    drawConcurrently(vectorOfProccess, vectorOfTypes, cache, 0);
+    for (Fractal *f : vectorOfProccess)
     {
-        f = vectorOfProccess.back();
-        f->draw();
-        vectorOfProccess.pop_back();
         delete (f);
     }
 }
 
+void drawConcurrently(const std::vector<Fractal *> &fractals, const std::vector<int> &types,
+                      RenderCache &cache, int numThreads)
+{
+    size_t count = fractals.size();
+    std::vector<RenderCache::Text> rendered(count);
+    std::vector<bool> ready(count, false);
+    size_t nextJob = 0, written = 0;
+    int share = 1;
+    std::mutex lock;
+    std::condition_variable changed;
+
+    auto worker = [&]()
+    {
+        std::unique_lock<std::mutex> guard(lock);
+        while (true)
+        {
+            changed.wait(guard, [&]()
+            {
+                return nextJob >= count || nextJob < written + REORDERWINDOW;
+            });
+            if (nextJob >= count)
+            {
+                return;
+            }
+            size_t job = nextJob++;
+            if (!fractals[job]->fitsInMemory())
+            {
+                continue;
+            }
+            guard.unlock();
+            RenderCache::Text text = cache.get(types[job], *fractals[job], share);
+            guard.lock();
+            rendered[job] = text;
+            ready[job] = true;
+            changed.notify_all();
+        }
+    };
+    if (numThreads <= 0)
+    {
+        numThreads = std::max(1, (int) std::thread::hardware_concurrency());
+    }
+    int workers = std::min(numThreads, (int) count);
+    share = std::max(1, numThreads / std::max(1, workers));
+    std::vector<std::thread> threads;
+    for (int i = 0; i < workers; i++)
+    {
+        threads.emplace_back(worker);
+    }
+
+    std::cout.flush();
+    std::unique_lock<std::mutex> guard(lock);
+    for (size_t i = 0; i < count; i++)
+    {
+        if (fractals[i]->fitsInMemory())
+        {
+            changed.wait(guard, [&]()
+            {
+                return (bool) ready[i];
+            });
+            RenderCache::Text text = rendered[i];
+            rendered[i] = nullptr;
+            guard.unlock();
+            Fractal::writeFrac(STDOUT_FILENO, *text);
+        }
+        else
+        {
+            guard.unlock();
+            fractals[i]->stream(STDOUT_FILENO);
+        }
+        guard.lock();
+        written = i + 1;
+        changed.notify_all();
+    }
+    guard.unlock();
+    for (auto &t : threads)
+    {
+        t.join();
+    }
+}
+
 Fractal *fractalD(int index, int dim)
 {
     switch (index)
@@ -93,10 +201,10 @@ Fractal *fractalD(int index, int dim)
 bool checkTwoStringAreValidNums(std::string const &a, std::string const &b)
 {
     int numA = 0, numB = 0;
-    if (sscanf(a.c_str(), "%d", &numA) == (int) a.length() &&
-        sscanf(b.c_str(), "%d", &numB) == (int) b.length())
+    if (sscanf(a.c_str(), "%d", &numA) == 1 && std::to_string(numA) == a &&
+        sscanf(b.c_str(), "%d", &numB) == 1 && std::to_string(numB) == b)
     {
-        if (numA >= 1 && numA <= 3 && numB > 0 && numB < 7)
+        if (numA >= 1 && numA <= 3 && numB > 0 && numB <= MAXDIM)
         {
             return true;
         }
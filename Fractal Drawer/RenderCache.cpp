@@ -0,0 +1,119 @@
+//
+// Created by tal.shaked3 on 14/01/2020.
+//
+
+#include "RenderCache.h"
+
+/**
+ * @brief constructor
+ * @param memoryCap - the most chars of rendered text the cache would hold
+ */
+RenderCache::RenderCache(size_t memoryCap) : _memoryCap(memoryCap), _usage(0)
+{
+}
+
+/**
+ * @brief returns the rendered text of a fractal - from the cache if it is there, and
+ * otherwise by rendering it (out of a lower level of it if possible) and caching it.
+ * @param type - the type of the fractal
+ * @param fractal - the fractal
+ * @param numThreads - the number of threads to render the fractal with. 0 means one per
+ * core.
+ * @return the text of the fractal
+ */
+RenderCache::Text RenderCache::get(int type, const Fractal &fractal, int numThreads)
+{
+    long key = _key(type, fractal.getLevel());
+    std::unique_lock<std::mutex> guard(_lock);
+    auto found = _entries.find(key);
+    if (found != _entries.end())
+    {
+        _touch(found->second);
+        std::shared_future<Text> text = found->second.text;
+        guard.unlock();
+        return text.get();
+    }
+
+    Text lower;
+    int lowerLevel = 0;
+    if (fractal.isSelfSimilar())
+    {
+        for (int level = fractal.getLevel() - 1; level > 0 && lower == nullptr; level--)
+        {
+            auto block = _entries.find(_key(type, level));
+            if (block != _entries.end() && block->second.done)
+            {
+                _touch(block->second);
+                lower = block->second.text.get();
+                lowerLevel = level;
+            }
+        }
+    }
+    std::promise<Text> promise;
+    _lru.push_front(key);
+    _entries[key] = Entry{promise.get_future().share(), 0, false, _lru.begin()};
+    guard.unlock();
+
+    Text text;
+    try
+    {
+        text = std::make_shared<const std::vector<char>>(
+                lower ? fractal.renderFrom(*lower, lowerLevel, numThreads)
+                      : fractal.render(numThreads));
+    }
+    catch (...)
+    {
+        promise.set_exception(std::current_exception());
+        guard.lock();
+        _lru.erase(_entries[key].lru);
+        _entries.erase(key);
+        throw;
+    }
+    promise.set_value(text);
+
+    guard.lock();
+    Entry &entry = _entries[key];
+    entry.size = text->size();
+    entry.done = true;
+    _usage += entry.size;
+    _evict();
+    return text;
+}
+
+/**
+ * @brief marks an entry as the most recently used one
+ */
+void RenderCache::_touch(Entry &entry)
+{
+    _lru.splice(_lru.begin(), _lru, entry.lru);
+}
+
+/**
+ * @brief evicts rendered fractals, least recently used first, until the cache holds no more
+ * than its memory cap. fractals that are still being rendered are not evicted.
+ */
+void RenderCache::_evict()
+{
+    auto it = _lru.end();
+    while (_usage > _memoryCap && it != _lru.begin())
+    {
+        --it;
+        Entry &entry = _entries[*it];
+        if (!entry.done)
+        {
+            continue;
+        }
+        _usage -= entry.size;
+        _entries.erase(*it);
+        it = _lru.erase(it);
+    }
+}
+
+/**
+ * @return the number of chars of rendered text in the cache
+ */
+size_t RenderCache::getUsage()
+{
+    std::lock_guard<std::mutex> guard(_lock);
+    return _usage;
+}
@@ -0,0 +1,90 @@
+//
+// Created by tal.shaked3 on 14/01/2020.
+//
+#include <vector>
+#include <list>
+#include <memory>
+#include <future>
+#include <mutex>
+#include <unordered_map>
+#include "Fractal.h"
+
+#ifndef UNTITLED_RENDERCACHE_H
+#define UNTITLED_RENDERCACHE_H
+
+#define CACHECAP (1 << 28)
+
+/**
+ * @brief a thread safe cache of rendered fractals (see Fractal::render()), keyed by the type of
+ * the fractal and its level. it holds at most memoryCap chars of rendered text, evicting the
+ * least recently used fractals first. a missing self similar fractal is built out of the
+ * highest lower level of its type that is in the cache, if there is one. a fractal that is
+ * being rendered is waited for by the other threads asking for it, not rendered again.
+ */
+class RenderCache
+{
+public:
+    typedef std::shared_ptr<const std::vector<char>> Text;
+
+private:
+    /**
+     * @brief a fractal in the cache
+     */
+    struct Entry
+    {
+        std::shared_future<Text> text;
+        size_t size;
+        bool done;
+        std::list<long>::iterator lru;
+    };
+
+    size_t _memoryCap;
+    size_t _usage;
+    std::unordered_map<long, Entry> _entries;
+    std::list<long> _lru;
+    std::mutex _lock;
+
+    /**
+     * @return the key of a fractal in the cache
+     */
+    static long _key(int type, int level)
+    {
+        return (long) type * 1024 + level;
+    }
+
+    /**
+     * @brief marks an entry as the most recently used one
+     */
+    void _touch(Entry &entry);
+
+    /**
+     * @brief evicts rendered fractals, least recently used first, until the cache holds no more
+     * than its memory cap. fractals that are still being rendered are not evicted.
+     */
+    void _evict();
+
+public:
+    /**
+     * @brief constructor
+     * @param memoryCap - the most chars of rendered text the cache would hold
+     */
+    explicit RenderCache(size_t memoryCap = CACHECAP);
+
+    /**
+     * @brief returns the rendered text of a fractal - from the cache if it is there, and
+     * otherwise by rendering it (out of a lower level of it if possible) and caching it.
+     * @param type - the type of the fractal
+     * @param fractal - the fractal
+     * @param numThreads - the number of threads to render the fractal with. 0 means one per
+     * core.
+     * @return the text of the fractal
+     */
+    Text get(int type, const Fractal &fractal, int numThreads = 0);
+
+    /**
+     * @return the number of chars of rendered text in the cache
+     */
+    size_t getUsage();
+};
+
+#endif //UNTITLED_RENDERCACHE_H
@@ -0,0 +1,232 @@
+//
+// Created by tal.shaked3 on 24/01/2020.
+//
+
+#ifndef CPPEX3_AHOCORASICK_HPP
+#define CPPEX3_AHOCORASICK_HPP
+#define ROOT 0
+#define ALPHABET 256
+#define BOUNDSTRIDE 64
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <algorithm>
+#include "HashMap.hpp"
+#include "HashPolicies.hpp"
+
+/**
+ * @brief a multi pattern matcher (an aho-corasick automaton). it is built once out of all the
+ * phrases of a database and their damage, and then scores a message in a single pass over it -
+ * summing the damage of every appearance (overlapping ones included) of every phrase.
+ */
+class AhoCorasick
+{
+private:
+    std::vector<int> _fail;
+    std::vector<int> _parent;
+    std::vector<int> _depth;
+    std::vector<unsigned char> _char;
+    std::vector<long> _damage;
+    long _maxDamage{};
+    int _rootNext[ALPHABET]{};
+    HashMap<long, int, IntHash> _next;
+
+    /**
+     * @param state - a state of the automaton
+     * @param c - a char
+     * @return the key of the edge going out of state with c in the edges map
+     */
+    static long _edge(int state, unsigned char c)
+    {
+        return (long) state * ALPHABET + c;
+    }
+
+    /**
+     * @brief creates a new state in the automaton, as a child of parent by the char c
+     * @return the index of the new state
+     */
+    int _addState(int parent, unsigned char c)
+    {
+        int state = _fail.size();
+        _fail.push_back(ROOT);
+        _parent.push_back(parent);
+        _depth.push_back(state == ROOT ? 0 : _depth[parent] + 1);
+        _char.push_back(c);
+        _damage.push_back(0);
+        return state;
+    }
+
+    /**
+     * @brief adds a phrase to the trie of the automaton
+     * @param phrase - the phrase to add
+     * @param damage - the damage of a single appearance of the phrase
+     */
+    void _addPhrase(std::string_view phrase, int damage)
+    {
+        int state = ROOT;
+        for (char ch : phrase)
+        {
+            auto c = (unsigned char) ch;
+            if (state == ROOT)
+            {
+                if (_rootNext[c] == ROOT)
+                {
+                    _rootNext[c] = _addState(ROOT, c);
+                }
+                state = _rootNext[c];
+                continue;
+            }
+            auto res = _next.try_emplace(_edge(state, c), (int) _fail.size());
+            if (res.second)
+            {
+                _addState(state, c);
+            }
+            state = res.first->second;
+        }
+        _damage[state] += damage;
+    }
+
+    /**
+     * @brief sets the failure link of every state, going over the states by their depth so
+     * that the link of every shallower state is already known. the damage of each state is
+     * accumulated with the damage of its failure state, so that it sums up all the phrases
+     * that end there.
+     */
+    void _buildFailLinks()
+    {
+        std::vector<int> order(_fail.size());
+        for (int i = 0; i < (int) order.size(); i++)
+        {
+            order[i] = i;
+        }
+        std::stable_sort(order.begin(), order.end(), [this](int a, int b)
+        {
+            return _depth[a] < _depth[b];
+        });
+        for (int state : order)
+        {
+            if (_depth[state] <= 1)
+            {
+                continue;
+            }
+            _fail[state] = _step(_fail[_parent[state]], _char[state]);
+            _damage[state] += _damage[_fail[state]];
+        }
+    }
+
+    /**
+     * @param chars - a number of chars
+     * @param need - the damage still needed, positive
+     * @return true if so many chars can't add up to the needed damage, false otherwise
+     */
+    bool _cannotReach(size_t chars, long need) const
+    {
+        return _maxDamage == 0 || (long) chars <= (need - 1) / _maxDamage;
+    }
+
+    /**
+     * @brief moves the automaton one char forward
+     * @param state - the current state
+     * @param c - the next char of the text
+     * @return the next state
+     */
+    int _step(int state, unsigned char c) const
+    {
+        while (state != ROOT)
+        {
+            auto it = _next.find(_edge(state, c));
+            if (it != _next.end())
+            {
+                return it->second;
+            }
+            state = _fail[state];
+        }
+        return _rootNext[c];
+    }
+
+public:
+    /**
+     * @brief builds the automaton out of a database of phrases and their damage
+     * @param db - the map of the phrases (as keys) and their damage (as values) - a HashMap of
+     * any hash and equality policies, or a HashMapView
+     */
+    template<class Map>
+    explicit AhoCorasick(const Map &db)
+    {
+        _addState(ROOT, 0);
+        for (const auto &p : db)
+        {
+            _addPhrase(p.first, p.second);
+        }
+        _buildFailLinks();
+        for (long damage : _damage)
+        {
+            _maxDamage = std::max(_maxDamage, damage);
+        }
+    }
+
+    /**
+     * @brief scores a message - sums up the damage of all the appearances of the phrases in it
+     * @param msg - the message
+     * @return the total damage of the message
+     */
+    long score(const std::string &msg) const
+    {
+        long sum = 0;
+        int state = ROOT;
+        for (char ch : msg)
+        {
+            state = _step(state, (unsigned char) ch);
+            sum += _damage[state];
+        }
+        return sum;
+    }
+
+    /**
+     * @brief decides whether a message scores at least the threshold, stopping as soon as the
+     * answer is known: once the damage so far reaches the threshold (the damage of a phrase is
+     * never negative, so it can only grow), or once even the most damage the rest of the
+     * message could add - the largest damage of a state for every char left - can't reach it.
+     * a threshold of 0 or less is always reached, as with score. the second bound is checked
+     * every BOUNDSTRIDE chars.
+     * @param msg - the message
+     * @param threshold - the threshold
+     * @return true if score(msg) >= threshold, false otherwise
+     */
+    bool reaches(const std::string &msg, long threshold) const
+    {
+        if (threshold <= 0)
+        {
+            return true;
+        }
+        long sum = 0;
+        int state = ROOT;
+        size_t len = msg.size();
+        for (size_t i = 0; i < len; i++)
+        {
+            if (i % BOUNDSTRIDE == 0 && _cannotReach(len - i, threshold - sum))
+            {
+                return false;
+            }
+            state = _step(state, (unsigned char) msg[i]);
+            sum += _damage[state];
+            if (sum >= threshold)
+            {
+                return true;
+            }
+        }
+        return sum >= threshold;
+    }
+
+    /**
+     * @return the number of states in the automaton
+     */
+    int stateCount() const
+    {
+        return _fail.size();
+    }
+};
+
+
+#endif //CPPEX3_AHOCORASICK_HPP
@@ -0,0 +1,194 @@
+//
+// Created by talas on 1/30/2020.
+//
+
+#ifndef CPPEX3_ARENA_HPP
+#define CPPEX3_ARENA_HPP
+#define ARENASLAB (1 << 16)
+#define ARENAMAXSLAB (1 << 24)
+
+#include <vector>
+#include <new>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <algorithm>
+
+/**
+ * @brief a monotonic arena: memory is handed out from large slabs by bumping a pointer, and is
+ * never given back one allocation at a time - all of it is freed at once, with the arena. the
+ * slabs start at ARENASLAB bytes and double up to ARENAMAXSLAB, so a million small allocations
+ * cost a few dozen calls to the allocator of the system. an arena is not thread safe.
+ */
+class Arena
+{
+private:
+    std::vector<void *> _slabs;
+    char *_cur;
+    char *_end;
+    size_t _nextSlab;
+    size_t _used;
+
+    /**
+     * @brief allocates a slab from the system
+     * @param size - the size of the slab
+     * @return the slab
+     */
+    char *_newSlab(size_t size)
+    {
+        _slabs.reserve(_slabs.size() + 1);
+        void *slab = ::operator new(size);
+        _slabs.push_back(slab);
+        return static_cast<char *>(slab);
+    }
+
+    /**
+     * @return the address p rounded up to a multiple of align (a power of 2)
+     */
+    static uintptr_t _alignUp(uintptr_t p, size_t align)
+    {
+        return (p + align - 1) & ~(uintptr_t) (align - 1);
+    }
+
+public:
+    /**
+     * @brief constructor. no memory is allocated until the first allocation.
+     * @param slabSize - the size of the first slab
+     */
+    explicit Arena(size_t slabSize = ARENASLAB) :
+            _cur(nullptr), _end(nullptr), _nextSlab(slabSize), _used(0)
+    {
+    }
+
+    Arena(const Arena &) = delete;
+
+    Arena &operator=(const Arena &) = delete;
+
+    /**
+     * @brief destructor, frees all the memory of the arena
+     */
+    ~Arena()
+    {
+        release();
+    }
+
+    /**
+     * @brief allocates memory from the arena. an allocation that is larger than a quarter of a
+     * slab gets a block of its own, so the slab it would have ended is not wasted.
+     * @param size - the number of bytes
+     * @param align - the alignment of the memory, a power of 2
+     * @return the memory, valid until the arena is released
+     */
+    void *allocate(size_t size, size_t align)
+    {
+        uintptr_t at = _alignUp((uintptr_t) _cur, align);
+        if (_cur == nullptr || at + size > (uintptr_t) _end)
+        {
+            if (size + align > _nextSlab / 4)
+            {
+                _used += size;
+                return (void *) _alignUp((uintptr_t) _newSlab(size + align), align);
+            }
+            _cur = _newSlab(_nextSlab);
+            _end = _cur + _nextSlab;
+            _nextSlab = std::min(_nextSlab * 2, (size_t) ARENAMAXSLAB);
+            at = _alignUp((uintptr_t) _cur, align);
+        }
+        _cur = (char *) (at + size);
+        _used += size;
+        return (void *) at;
+    }
+
+    /**
+     * @brief frees all the memory of the arena at once. everything allocated from it becomes
+     * invalid.
+     */
+    void release()
+    {
+        for (void *slab : _slabs)
+        {
+            ::operator delete(slab);
+        }
+        _slabs.clear();
+        _cur = _end = nullptr;
+        _used = 0;
+    }
+
+    /**
+     * @return the number of bytes allocated from the arena since it was last released
+     */
+    size_t bytesUsed() const
+    {
+        return _used;
+    }
+
+    /**
+     * @return the number of blocks the arena holds from the system
+     */
+    size_t slabCount() const
+    {
+        return _slabs.size();
+    }
+};
+
+/**
+ * @brief an allocator that takes its memory from an Arena, for HashMap and the standard
+ * containers. deallocating does nothing; the memory is freed when the arena is. the arena must
+ * outlive everything allocated by the allocator.
+ * @tparam T - the type of the objects allocated
+ */
+template<class T>
+class ArenaAllocator
+{
+    template<class U>
+    friend class ArenaAllocator;
+
+private:
+    Arena *_arena;
+
+public:
+    typedef T value_type;
+
+    /**
+     * @brief constructor
+     * @param arena - the arena to allocate from
+     */
+    explicit ArenaAllocator(Arena &arena) noexcept : _arena(&arena)
+    {
+    }
+
+    /**
+     * @brief constructor of an allocator of another type, allocating from the same arena
+     */
+    template<class U>
+    ArenaAllocator(const ArenaAllocator<U> &other) noexcept : _arena(other._arena)
+    {
+    }
+
+    T *allocate(size_t n)
+    {
+        if (n > std::numeric_limits<size_t>::max() / sizeof(T))
+        {
+            throw std::bad_alloc{};
+        }
+        return static_cast<T *>(_arena->allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T *, size_t) noexcept
+    {
+    }
+
+    template<class U>
+    bool operator==(const ArenaAllocator<U> &rhs) const
+    {
+        return _arena == rhs._arena;
+    }
+
+    template<class U>
+    bool operator!=(const ArenaAllocator<U> &rhs) const
+    {
+        return _arena != rhs._arena;
+    }
+};
+
+#endif //CPPEX3_ARENA_HPP
@@ -0,0 +1,270 @@
+//
+// Created by talas on 1/29/2020.
+//
+
+#ifndef CPPEX3_CONCURRENTHASHMAP_HPP
+#define CPPEX3_CONCURRENTHASHMAP_HPP
+#define SHARDSPERTHREAD 4
+#define CACHELINE 64
+
+#include <vector>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <functional>
+#include "HashMap.hpp"
+#include "HashPolicies.hpp"
+
+/**
+ * @brief a hashmap that can be used from many threads at once. the keys are split between
+ * shards by their hash, and every shard is a HashMap of its own, guarded by its own lock - so
+ * threads working on different shards never wait for each other, lookups of a shard run
+ * together (they take its lock shared), and a shard that grows or shrinks is resized by
+ * itself while all the others stay available. the shards rehash incrementally, so a writer that
+ * happens to grow its shard holds the lock of the shard about as long as any other writer.
+ * since an item may be moved or erased by another thread at any time, no references or
+ * iterators to the items are given out: values are returned by copy, and items are changed
+ * only through the map.
+ * @tparam ValueT - the values in the map
+ * @tparam KeyT - the keys in the map
+ * @tparam Hash - the hash of the keys (see HashMap)
+ * @tparam KeyEqual - the equality of the keys (see HashMap)
+ */
+template<class KeyT, class ValueT, class Hash = std::hash<KeyT>,
+        class KeyEqual = std::equal_to<KeyT>>
+class ConcurrentHashMap
+{
+private:
+    /**
+     * @brief a shard of the map, on cache lines of its own so that the locks of different
+     * shards are never shared by one line
+     */
+    struct alignas(CACHELINE) Shard
+    {
+        mutable std::shared_mutex lock;
+        HashMap<KeyT, ValueT, Hash, KeyEqual> map;
+    };
+
+    std::vector<Shard> _shards;
+
+    /**
+     * @param k - a key
+     * @return the index of the shard the key belongs to. the hash is mixed first, since the map
+     * of the shard uses the low bits of the same hash for its buckets.
+     */
+    template<class K>
+    size_t _shardOf(const K &k) const
+    {
+        return IntHash{}(Hash{}(k)) & (_shards.size() - 1);
+    }
+
+public:
+    /**
+     * @brief constructor
+     * @param numShards - the number of shards, rounded up to a power of 2. 0 means
+     * SHARDSPERTHREAD for every core.
+     */
+    explicit ConcurrentHashMap(int numShards = 0) :
+            _shards([numShards]()
+                    {
+                        int wanted = numShards > 0 ? numShards : SHARDSPERTHREAD *
+                                     (int) std::max(1u, std::thread::hardware_concurrency());
+                        int size = 1;
+                        while (size < wanted)
+                        {
+                            size *= MULTIPLYBY;
+                        }
+                        return size;
+                    }())
+    {
+        for (Shard &shard : _shards)
+        {
+            shard.map.setIncrementalRehash(true);
+        }
+    }
+
+    ConcurrentHashMap(const ConcurrentHashMap &) = delete;
+
+    ConcurrentHashMap &operator=(const ConcurrentHashMap &) = delete;
+
+    /**
+     * @brief returning the size (how many items) are in the map. while other threads change the
+     * map, this is a snapshot of every shard at a slightly different time.
+     * @return by int
+     */
+    int size() const
+    {
+        int size = 0;
+        for (const Shard &shard : _shards)
+        {
+            std::shared_lock<std::shared_mutex> guard(shard.lock);
+            size += shard.map.size();
+        }
+        return size;
+    }
+
+    /**
+     * @brief checks if the map is empty (see size)
+     */
+    bool empty() const
+    {
+        return size() == 0;
+    }
+
+    /**
+     * @return the number of shards
+     */
+    int shardCount() const
+    {
+        return _shards.size();
+    }
+
+    /**
+     * @brief makes room for the given number of items, spread evenly over the shards
+     * @param n - the number of items
+     */
+    void reserve(int n)
+    {
+        for (Shard &shard : _shards)
+        {
+            std::unique_lock<std::shared_mutex> guard(shard.lock);
+            shard.map.reserve(n / (int) _shards.size() + 1);
+        }
+    }
+
+    /**
+     * @brief insert a key and a value to the map, if the key isn't in it already
+     * @param k - the key
+     * @param v - the value
+     * @return true if the key was inserted, false if it was in the map
+     */
+    bool insert(const KeyT &k, const ValueT &v)
+    {
+        Shard &shard = _shards[_shardOf(k)];
+        std::unique_lock<std::shared_mutex> guard(shard.lock);
+        return shard.map.try_emplace(k, v).second;
+    }
+
+    /**
+     * @brief sets the value of a key, inserting the key if it isn't in the map
+     * @param k - the key
+     * @param v - the value
+     * @return true if the key was inserted, false if it was in the map
+     */
+    bool insertOrAssign(const KeyT &k, const ValueT &v)
+    {
+        Shard &shard = _shards[_shardOf(k)];
+        std::unique_lock<std::shared_mutex> guard(shard.lock);
+        auto res = shard.map.try_emplace(k, v);
+        if (!res.second)
+        {
+            res.first->second = v;
+        }
+        return res.second;
+    }
+
+    /**
+     * @brief changes the value of a key in place, while no other thread can reach it. the key
+     * is inserted with a value constructed from args first if it isn't in the map.
+     * @param k - the key
+     * @param change - called with a reference to the value
+     * @param args - the arguments to construct the value from, for a new key
+     */
+    template<class Change, class... Args>
+    void update(const KeyT &k, Change change, Args &&... args)
+    {
+        Shard &shard = _shards[_shardOf(k)];
+        std::unique_lock<std::shared_mutex> guard(shard.lock);
+        change(shard.map.try_emplace(k, std::forward<Args>(args)...).first->second);
+    }
+
+    /**
+     * @brief this function checks whether the key is in the map
+     * @param k - a given key, or if Hash and KeyEqual are transparent, any value they accept
+     * @return - true if so, else false
+     */
+    template<class K>
+    bool containsKey(const K &k) const
+    {
+        const Shard &shard = _shards[_shardOf(k)];
+        std::shared_lock<std::shared_mutex> guard(shard.lock);
+        return shard.map.containsKey(k);
+    }
+
+    /**
+     * @brief looks up a key in the map
+     * @param k - a given key, or if Hash and KeyEqual are transparent, any value they accept
+     * @param value - set to a copy of the value of the key, if it is in the map
+     * @return - true if the key is in the map, else false
+     */
+    template<class K>
+    bool find(const K &k, ValueT &value) const
+    {
+        const Shard &shard = _shards[_shardOf(k)];
+        std::shared_lock<std::shared_mutex> guard(shard.lock);
+        auto it = shard.map.find(k);
+        if (it == shard.map.end())
+        {
+            return false;
+        }
+        value = it->second;
+        return true;
+    }
+
+    /**
+     * @brief this function returns the value of the given key in the map. if the key doesn't
+     * exist throws an error
+     * @param k - a key given
+     * @return - a copy of the value of the key
+     */
+    ValueT at(const KeyT &k) const
+    {
+        const Shard &shard = _shards[_shardOf(k)];
+        std::shared_lock<std::shared_mutex> guard(shard.lock);
+        return shard.map.at(k);
+    }
+
+    /**
+     * @brief this function get a key and erases it from the map
+     * @param k - the key to erase
+     * @return - true if the key was erased, false if it wasn't in the map
+     */
+    bool erase(const KeyT &k)
+    {
+        Shard &shard = _shards[_shardOf(k)];
+        std::unique_lock<std::shared_mutex> guard(shard.lock);
+        return shard.map.erase(k);
+    }
+
+    /**
+     * @brief erases all the items inside the map, a shard at a time
+     */
+    void clear()
+    {
+        for (Shard &shard : _shards)
+        {
+            std::unique_lock<std::shared_mutex> guard(shard.lock);
+            shard.map.clear();
+        }
+    }
+
+    /**
+     * @brief calls a function on every item of the map, a shard at a time. every shard is locked
+     * for reading while its items are visited, so the function must not change the map.
+     * @param visit - called with the key and the value of every item
+     */
+    template<class Visit>
+    void forEach(Visit visit) const
+    {
+        for (const Shard &shard : _shards)
+        {
+            std::shared_lock<std::shared_mutex> guard(shard.lock);
+            for (const auto &p : shard.map)
+            {
+                visit(p.first, p.second);
+            }
+        }
+    }
+};
+
+#endif //CPPEX3_CONCURRENTHASHMAP_HPP
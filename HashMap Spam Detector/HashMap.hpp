@@ -9,12 +9,22 @@
 #define ERROR1 "Error: Key not in map\n"
 #define ERROR2 "Error: The key vector and value vector don't match\n"
 #define MULTIPLYBY 2
+#define EMPTYSLOT (-1)
+#define INITCAPACITY 16
+#define REHASHSTEP 16
 
 #include <vector>
+#include <utility>
+#include <tuple>
+#include <new>
 #include <cstdlib>
 #include <exception>
 #include <stdexcept>
 #include <iostream>
+#include <iterator>
+#include <functional>
+#include <memory>
+#include <cstdint>
 
 
 /**
@@ -52,70 +62,417 @@ public:
 };
 
 /**
- * @brief a hashmap container, containing generic keys and values
+ * @brief a hashmap container, containing generic keys and values.
+ * the map is stored flat - as one array of slots with no allocation per bucket - and collisions
+ * are resolved by linear probing with the robin hood strategy: every item remembers how far it
+ * is from its own bucket, and an item that is further from its bucket takes over the slot of a
+ * closer one. this keeps the items of every bucket next to each other in the table. every item
+ * also remembers the low 32 bits of the hash of its key, so a resize never hashes a key again,
+ * and a lookup compares its key only to the items whose hash bits match.
+ * a resize normally moves all the items to the new table at once. with incremental rehashing
+ * turned on (see setIncrementalRehash) the old table is kept next to the new one instead, and
+ * every insert and erase moves a few more of its slots over, until it is empty.
  * @tparam ValueT - the values in the map
  * @tparam KeyT - the keys in the map
+ * @tparam Hash - the hash of the keys, a default constructible function object
+ * @tparam KeyEqual - the equality of the keys, a default constructible function object. if
+ * both Hash and KeyEqual are transparent (declare is_transparent), the map can be looked up
+ * with any type they accept, with no key built for the lookup - see HashPolicies.hpp.
+ * @tparam Alloc - the allocator of the table, an allocator of std::pair<KeyT, ValueT> (it is
+ * rebound for the distances array). a copy of a map gets its allocator through
+ * select_on_container_copy_construction, and assigning or swapping maps swaps their allocators
+ * too. see Arena.hpp for an allocator that frees everything at once.
  */
-template<class KeyT, class ValueT>
+template<class KeyT, class ValueT, class Hash = std::hash<KeyT>,
+        class KeyEqual = std::equal_to<KeyT>, class Alloc = std::allocator<std::pair<KeyT, ValueT>>>
 class HashMap
 {
 private:
+    /**
+     * @brief what the table knows of a slot besides its item: the distance of the item from its
+     * bucket (EMPTYSLOT for an empty slot), and the low 32 bits of the hash of its key - enough
+     * to find the bucket of the key in any table the map can have.
+     */
+    struct SlotInfo
+    {
+        int dist;
+        uint32_t hash;
+    };
+
     int _capacity{};
     int _curItems{};
     float const _upperLoadFactor = (float) UPPERLF;
     float const _lowerLoadFactor = (float) LOWERLF;
-    std::vector<std::pair<KeyT, ValueT>> *_table;
+    std::pair<KeyT, ValueT> *_table;
+    SlotInfo *_info;
+    bool _incremental{};
+    int _oldCapacity{};
+    int _oldItems{};
+    int _oldNext{};
+    std::pair<KeyT, ValueT> *_oldTable{};
+    SlotInfo *_oldInfo{};
+    Alloc _alloc;
+
+    typedef std::allocator_traits<Alloc> AllocTraits;
+    typedef typename AllocTraits::template rebind_alloc<SlotInfo> InfoAlloc;
+    typedef std::allocator_traits<InfoAlloc> InfoAllocTraits;
+
+    /**
+     * @brief allocates the storage of a table of the given size. the slots are left
+     * unconstructed and are all marked as empty.
+     * @param size - the number of slots
+     * @param table - the slots array
+     * @param info - the slot info array
+     */
+    void _allocTable(int size, std::pair<KeyT, ValueT> *&table, SlotInfo *&info)
+    {
+        InfoAlloc infoAlloc(_alloc);
+        table = AllocTraits::allocate(_alloc, size);
+        info = InfoAllocTraits::allocate(infoAlloc, size);
+        for (int i = 0; i < size; i++)
+        {
+            info[i].dist = EMPTYSLOT;
+        }
+    }
+
+    /**
+     * @brief frees a table, destructing the items in it first
+     * @param size - the number of slots
+     * @param table - the slots array, or nullptr for no table
+     * @param info - the slot info array
+     * @param destruct - false if the table is known to be empty, and its slots need no check
+     */
+    void _freeTable(int size, std::pair<KeyT, ValueT> *table, SlotInfo *info,
+                    bool destruct = true)
+    {
+        if (table == nullptr)
+        {
+            return;
+        }
+        for (int i = 0; destruct && i < size; i++)
+        {
+            if (info[i].dist != EMPTYSLOT)
+            {
+                table[i].~pair();
+            }
+        }
+        InfoAlloc infoAlloc(_alloc);
+        AllocTraits::deallocate(_alloc, table, size);
+        InfoAllocTraits::deallocate(infoAlloc, info, size);
+    }
+
+    /**
+     * @brief frees the old table of a rehash, once all its items were moved out (or, if
+     * destruct, destructs the ones left in it first), and ends the rehash
+     */
+    void _freeOldTable(bool destruct)
+    {
+        _freeTable(_oldCapacity, _oldTable, _oldInfo, destruct);
+        _oldCapacity = _oldItems = _oldNext = 0;
+        _oldTable = nullptr;
+        _oldInfo = nullptr;
+    }
+
+    /**
+     * @brief walks the probe sequence of a key in a table, once. the key is compared only to
+     * items whose hash matches its own in the bits the slot info keeps.
+     * @param size - the number of slots of the table
+     * @param table - the slots array
+     * @param info - the slot info array
+     * @param hash - the hash of the key
+     * @param k - the key to look for
+     * @param index - set to the slot holding the key, or if it is not in the table, to the slot
+     * an item with this key should be placed at
+     * @param dist - set to the distance of that slot from the bucket of the key
+     * @return true if the key was found, false otherwise
+     */
+    template<class K>
+    static bool _probe(int size, const std::pair<KeyT, ValueT> *table, const SlotInfo *info,
+                       size_t hash, const K &k, int &index, int &dist)
+    {
+        if (size == 0)
+        {
+            index = dist = 0;
+            return false;
+        }
+        index = hash & (size - 1);
+        for (dist = 0; info[index].dist != EMPTYSLOT && dist <= info[index].dist; dist++)
+        {
+            if (info[index].hash == (uint32_t) hash && KeyEqual{}(table[index].first, k))
+            {
+                return true;
+            }
+            index = (index + 1) & (size - 1);
+        }
+        return false;
+    }
 
     /**
-     * @brief this func finds the index of key in a specific bucket of the hashmap
-     * @param k -the key to find in the bucket
-     * @return the index of the key in the bucket. in case not found an error would be thrown but
-     * the program won't crash
+     * @brief this func finds the slot of the key in the map. the slots of the old table of a
+     * rehash are numbered after the ones of the table, from _capacity on. this is the only
+     * place a lookup hashes the key, once for both tables.
+     * @param k -the key to find
+     * @return the index of the slot holding the key, -1 if not found
      */
-    int _indexInBucket(const KeyT &k) const
+    template<class K>
+    int _findSlot(const K &k) const
     {
-        if (containsKey(k))
+        size_t hash = Hash{}(k);
+        int index, dist;
+        if (_probe(_capacity, _table, _info, hash, k, index, dist))
         {
-            int bIndex = bucketIndex(k);
-            int index = 0;
-            for (auto p : _table[bIndex])
+            return index;
+        }
+        if (_oldTable != nullptr &&
+            _probe(_oldCapacity, _oldTable, _oldInfo, hash, k, index, dist))
+        {
+            return _capacity + index;
+        }
+        return -1;
+    }
+
+    /**
+     * @param slot - a slot of the map, numbered as by _findSlot
+     * @return the item in the slot
+     */
+    std::pair<KeyT, ValueT> &_item(int slot) const
+    {
+        return slot < _capacity ? _table[slot] : _oldTable[slot - _capacity];
+    }
+
+    /**
+     * @return an iterator starting at a slot of the map, numbered as by _findSlot
+     */
+    auto _iteratorAt(int slot) const
+    {
+        return iterator(_table, _info, _capacity, slot, _oldTable, _oldInfo, _oldCapacity);
+    }
+
+    /**
+     * @brief places an item that is known not to be in the map in the table, starting from a
+     * given slot of its probe sequence. items closer to their bucket are pushed forward. the
+     * table must have a free slot.
+     * @param index - the slot to start from
+     * @param dist - the distance of this slot from the bucket of the item
+     * @param hash - the hash of the key of the item
+     * @param item - the item to place
+     * @return the index of the slot the item was placed at
+     */
+    int _placeFrom(int index, int dist, uint32_t hash, std::pair<KeyT, ValueT> &&item)
+    {
+        int placedAt = -1;
+        for (;; dist++)
+        {
+            if (_info[index].dist == EMPTYSLOT)
             {
-                if (p.first == k)
+                new(&_table[index]) std::pair<KeyT, ValueT>(std::move(item));
+                _info[index] = SlotInfo{dist, hash};
+                return placedAt == -1 ? index : placedAt;
+            }
+            if (_info[index].dist < dist)
+            {
+                std::swap(item, _table[index]);
+                std::swap(dist, _info[index].dist);
+                std::swap(hash, _info[index].hash);
+                if (placedAt == -1)
                 {
-                    return index;
+                    placedAt = index;
                 }
-                index++;
+            }
+            index = (index + 1) & (_capacity - 1);
+        }
+    }
+
+    /**
+     * @brief places an item that is known not to be in the map in the table, in its bucket or
+     * after it. its key is not hashed again.
+     * @param hash - the hash of the key of the item, as kept in its slot info
+     * @param item - the item to place
+     */
+    void _placeHashed(uint32_t hash, std::pair<KeyT, ValueT> &&item)
+    {
+        _placeFrom(hash & (_capacity - 1), 0, hash, std::move(item));
+    }
+
+    /**
+     * @brief removes the item in the given slot of a table, and shifts back the items after it
+     * that are not in their own bucket, so no tombstones are left in the table.
+     * @param size - the number of slots of the table
+     * @param table - the slots array
+     * @param info - the slot info array
+     * @param index - the slot to clear
+     */
+    static void _eraseSlot(int size, std::pair<KeyT, ValueT> *table, SlotInfo *info, int index)
+    {
+        table[index].~pair();
+        int next = (index + 1) & (size - 1);
+        while (info[next].dist != EMPTYSLOT && info[next].dist > 0)
+        {
+            new(&table[index]) std::pair<KeyT, ValueT>(std::move(table[next]));
+            table[next].~pair();
+            info[index] = SlotInfo{info[next].dist - 1, info[next].hash};
+            index = next;
+            next = (next + 1) & (size - 1);
+        }
+        info[index].dist = EMPTYSLOT;
+    }
+
+    /**
+     * @brief removes the item in the given slot of the map, numbered as by _findSlot. the
+     * rehash ends when the last item of the old table is removed.
+     * @param slot - the slot to clear
+     */
+    void _eraseSlot(int slot)
+    {
+        if (slot < _capacity)
+        {
+            _eraseSlot(_capacity, _table, _info, slot);
+            return;
+        }
+        _eraseSlot(_oldCapacity, _oldTable, _oldInfo, slot - _capacity);
+        if (--_oldItems == 0)
+        {
+            _freeOldTable(false);
+        }
+    }
+
+    /**
+     * @brief moves items of the old table of a rehash to the table, going over its slots in
+     * order. a slot is left only once it is empty - the backward shift of _eraseSlot may bring
+     * another item in to it - so the slots before _oldNext are all empty.
+     * @param steps - the number of slots to check and items to move, in total
+     */
+    void _migrate(int steps)
+    {
+        for (; _oldTable != nullptr && steps > 0; steps--)
+        {
+            if (_oldInfo[_oldNext].dist == EMPTYSLOT)
+            {
+                _oldNext++;
+                continue;
+            }
+            _placeHashed(_oldInfo[_oldNext].hash, std::move(_oldTable[_oldNext]));
+            _eraseSlot(_capacity + _oldNext);
+        }
+    }
+
+    /**
+     * @brief moves all the items left in the old table of a rehash to the table
+     */
+    void _finishRehash()
+    {
+        _migrate(MULTIPLYBY * _oldCapacity);
+    }
+
+    /**
+     * @brief copies the table of another hashmap into this one, which is assumed to hold no
+     * table at the moment. the items of the old table of a rehash of hm are copied straight in
+     * to the table.
+     * @param hm - the hashmap to copy
+     */
+    void _copyTable(const HashMap &hm)
+    {
+        _capacity = hm._capacity;
+        _curItems = hm._curItems;
+        _incremental = hm._incremental;
+        _allocTable(_capacity, _table, _info);
+        for (int i = 0; i < _capacity; i++)
+        {
+            if (hm._info[i].dist != EMPTYSLOT)
+            {
+                new(&_table[i]) std::pair<KeyT, ValueT>(hm._table[i]);
+                _info[i] = hm._info[i];
+            }
+        }
+        for (int i = 0; i < hm._oldCapacity; i++)
+        {
+            if (hm._oldInfo[i].dist != EMPTYSLOT)
+            {
+                _placeHashed(hm._oldInfo[i].hash, std::pair<KeyT, ValueT>(hm._oldTable[i]));
             }
         }
-        return -1;
     }
 
     /**
-     * @brief resizes the table of the hashmap, according to the newsize given. copies all the
-     * previous item in the map to the new table.
+     * @brief resizes the table of the hashmap, according to the newsize given. moves all the
+     * previous item in the map to the new table, those of a rehash that is under way included.
+     * no key is hashed: the items are placed by the hashes kept in their slot info.
      * @param newSize - the new size that the table should be
      */
     void _resizeTable(int newSize);
 
     /**
-     * @brief this function checks whether to resize the table.
-     * @return true if resizing happened, false otherwise
+     * @brief resizes the table of the hashmap to the given size - at once, or if incremental
+     * rehashing is on, by starting a rehash to a table of this size (after the one under way,
+     * if any, is finished)
+     * @param newSize - the new size that the table should be
+     */
+    void _resize(int newSize);
+
+    /**
+     * @brief the implementation of try_emplace, for a key that is copied or moved in
+     */
+    template<class K, class... Args>
+    auto _emplace(K &&k, Args &&... args)
+    {
+        if (_capacity == 0)
+        {
+            _resizeTable(INITCAPACITY);
+        }
+        _migrate(REHASHSTEP);
+        size_t hash = Hash{}(k);
+        int index, dist;
+        if (_probe(_capacity, _table, _info, hash, k, index, dist))
+        {
+            return std::make_pair(_iteratorAt(index), false);
+        }
+        int oldIndex, oldDist;
+        if (_oldTable != nullptr &&
+            _probe(_oldCapacity, _oldTable, _oldInfo, hash, k, oldIndex, oldDist))
+        {
+            return std::make_pair(_iteratorAt(_capacity + oldIndex), false);
+        }
+        // the table is grown before the item is placed, so no other item moves it afterwards
+        if (_curItems + 1 >= _capacity * _upperLoadFactor)
+        {
+            _resize(_capacity * MULTIPLYBY);
+            _probe(_capacity, _table, _info, hash, k, index, dist);
+        }
+        index = _placeFrom(index, dist, (uint32_t) hash, std::pair<KeyT, ValueT>(
+                std::piecewise_construct, std::forward_as_tuple(std::forward<K>(k)),
+                std::forward_as_tuple(std::forward<Args>(args)...)));
+        _curItems++;
+        return std::make_pair(_iteratorAt(index), true);
+    }
+
+    /**
+     * @brief this function checks whether to shrink the table, and shrinks it to the least
+     * size that keeps the items over the lower load factor.
      */
-    void _checkIfToResize(int flag);
+    void _checkIfToShrink();
 
 public:
+    class iterator;
+
     /**
      * @brief the default constructor of the map
      */
-    HashMap() : _capacity(16), _curItems(0)
+    HashMap() : HashMap(Alloc())
     {
-        using namespace std;
-        _table = new vector<pair<KeyT, ValueT>>[16];
+    }
+
+    /**
+     * @brief a constructor of an empty map, with the given allocator
+     * @param alloc - the allocator of the table
+     */
+    explicit HashMap(const Alloc &alloc) : _capacity(INITCAPACITY), _curItems(0), _alloc(alloc)
+    {
+        _allocTable(_capacity, _table, _info);
     }
 
     /**
      * @brief a constructor of the hashmap, when initializing it by 2 vectors, one of keys and
-     * one of values. the arrays must match by length
+     * one of values. the arrays must match by length. the table is sized once for all of them.
      * @param vKeys - the key vector
      * @param vValues - the value vector
      */
@@ -128,6 +485,7 @@ public:
             throw VectorDontMatchException{};
         }
         int size = vKeys.size();
+        reserve(size);
         for (int i = 0; i < size; i++)
         {
             (*this)[vKeys[i]] = vValues[i];
@@ -135,26 +493,83 @@ public:
     }
 
     /**
-     * @brief the copy constructor of the hashmap.
-     * @param hm - a hashmap to copy
+     * @brief a constructor of the hashmap out of 2 vectors as above, moving the keys and the
+     * values in to the map instead of copying them.
+     * @param vKeys - the key vector
+     * @param vValues - the value vector
      */
-    HashMap(HashMap &hm)
+    HashMap(std::vector<KeyT> &&vKeys, std::vector<ValueT> &&vValues) :
+            HashMap()
     {
-        _table = new std::vector<std::pair<KeyT, ValueT>>[hm.capacity()];
-        _curItems = hm._curItems;
-        _capacity = hm.capacity();
-        for (int i = 0; i < _capacity; i++)
+        if (vKeys.size() != vValues.size())
         {
-            _table[i] = hm._table[i];
+            throw VectorDontMatchException{};
+        }
+        int size = vKeys.size();
+        reserve(size);
+        for (int i = 0; i < size; i++)
+        {
+            (*this)[std::move(vKeys[i])] = std::move(vValues[i]);
         }
     }
 
+    /**
+     * @brief a constructor of the hashmap out of a range of key and value pairs. the table is
+     * sized once for the whole range, and the pairs are moved in if the range gives rvalues
+     * (a range of std::move_iterator, for example). a key that repeats takes its last value.
+     * @param first - the start of the range
+     * @param last - the end of the range
+     */
+    template<class ForwardIt>
+    HashMap(ForwardIt first, ForwardIt last) : HashMap()
+    {
+        reserve((int) std::distance(first, last));
+        for (; first != last; ++first)
+        {
+            auto &&item = *first;
+            (*this)[std::forward<decltype(item)>(item).first] =
+                    std::forward<decltype(item)>(item).second;
+        }
+    }
+
+    /**
+     * @brief the copy constructor of the hashmap.
+     * @param hm - a hashmap to copy
+     */
+    HashMap(const HashMap &hm) :
+            _alloc(AllocTraits::select_on_container_copy_construction(hm._alloc))
+    {
+        _copyTable(hm);
+    }
+
+    /**
+     * @brief the move constructor of the hashmap. takes over the table of hm without copying or
+     * allocating anything, leaving hm empty with no table (it allocates one again on its next
+     * insert).
+     * @param hm - a hashmap to move
+     */
+    HashMap(HashMap &&hm) noexcept :
+            _capacity(hm._capacity), _curItems(hm._curItems), _table(hm._table), _info(hm._info),
+            _incremental(hm._incremental), _oldCapacity(hm._oldCapacity),
+            _oldItems(hm._oldItems), _oldNext(hm._oldNext), _oldTable(hm._oldTable),
+            _oldInfo(hm._oldInfo), _alloc(hm._alloc)
+    {
+        hm._capacity = 0;
+        hm._curItems = 0;
+        hm._table = nullptr;
+        hm._info = nullptr;
+        hm._oldCapacity = hm._oldItems = hm._oldNext = 0;
+        hm._oldTable = nullptr;
+        hm._oldInfo = nullptr;
+    }
+
     /**
      * default constructor
      */
     ~HashMap()
     {
-        delete[](_table);
+        _freeTable(_capacity, _table, _info);
+        _freeTable(_oldCapacity, _oldTable, _oldInfo);
     }
 
     /**
@@ -167,7 +582,8 @@ public:
     }
 
     /**
-     * @brief returning the current capacity of the hashmap
+     * @brief returning the current capacity of the hashmap (of its new table, while a rehash
+     * is under way)
      * @return as int
      */
     int capacity() const
@@ -184,6 +600,76 @@ public:
         return _curItems == 0;
     }
 
+    /**
+     * @brief turns incremental rehashing on or off. when it is on, a resize allocates the new
+     * table but moves no items: the old table stays next to it and is looked up as well, and
+     * every insert and erase moves up to REHASHSTEP more of its slots, so no single call pays
+     * for moving the whole map. in this mode an insert of a key that is already in the map may
+     * move items too. turning it off finishes the rehash under way, if any.
+     * @param on - true to turn it on, false to turn it off
+     */
+    void setIncrementalRehash(bool on)
+    {
+        _incremental = on;
+        if (!on)
+        {
+            _finishRehash();
+        }
+    }
+
+    /**
+     * @return true if a rehash is under way - the map has an old table left to move, else false
+     */
+    bool isRehashing() const
+    {
+        return _oldTable != nullptr;
+    }
+
+    /**
+     * @brief makes room in the table for the given number of items, so that inserting them
+     * won't resize it. the table is never shrunk by this. a rehash under way is finished.
+     * @param n - the number of items
+     */
+    void reserve(int n)
+    {
+        int newSize = _capacity == 0 ? INITCAPACITY : _capacity;
+        while (n >= newSize * _upperLoadFactor)
+        {
+            newSize *= MULTIPLYBY;
+        }
+        if (newSize != _capacity)
+        {
+            _resizeTable(newSize);
+        }
+        else
+        {
+            _finishRehash();
+        }
+    }
+
+    /**
+     * @brief resizes the table to the given number of slots (rounded up to a power of 2), or to
+     * the least size that keeps the current items under the upper load factor if it is larger.
+     * unlike reserve(), this can shrink the table. a rehash under way is finished.
+     * @param n - the number of slots
+     */
+    void rehash(int n)
+    {
+        int newSize = 1;
+        while (newSize < n || _curItems >= newSize * _upperLoadFactor)
+        {
+            newSize *= MULTIPLYBY;
+        }
+        if (newSize != _capacity)
+        {
+            _resizeTable(newSize);
+        }
+        else
+        {
+            _finishRehash();
+        }
+    }
+
     /**
      * @brief insert a key and a value to the map. if the key already exists an error is thrown
      * @param k - the key
@@ -192,16 +678,63 @@ public:
      */
     bool insert(const KeyT &k, const ValueT &v)
     {
-        using namespace std;
-        if (containsKey(k))
+        return try_emplace(k, v).second;
+    }
+
+    /**
+     * @brief inserts a key to the map with a value constructed from the given arguments, if
+     * the key is not already in it. the key is hashed and looked up only once.
+     * @param k - the key
+     * @param args - the arguments to construct the value from
+     * @return - an iterator to the item of the key, and true if it was inserted (false if the
+     * key was already in the map, which is left unchanged)
+     */
+    template<class... Args>
+    std::pair<iterator, bool> try_emplace(const KeyT &k, Args &&... args)
+    {
+        return _emplace(k, std::forward<Args>(args)...);
+    }
+
+    /**
+     * @brief as above, moving the key in to the map if it is inserted
+     */
+    template<class... Args>
+    std::pair<iterator, bool> try_emplace(KeyT &&k, Args &&... args)
+    {
+        return _emplace(std::move(k), std::forward<Args>(args)...);
+    }
+
+    /**
+     * @brief looks up a key in the map
+     * @param k - the key
+     * @return - an iterator to the item of the key, or end() if it isn't in the map
+     */
+    iterator find(const KeyT &k) const
+    {
+        int index = _findSlot(k);
+        if (index == -1)
         {
-            return false;
+            return end();
         }
-        int index = std::hash<KeyT>{}(k) & (_capacity - 1);
-        _table[index].push_back({k, v});
-        _curItems++;
-        _checkIfToResize(0);
-        return true;
+        return _iteratorAt(index);
+    }
+
+    /**
+     * @brief looks up a key in the map by a value of another type, with no key built for it.
+     * only if Hash and KeyEqual are transparent.
+     * @param k - a value equal to the key (such as a std::string_view of a std::string key)
+     * @return - an iterator to the item of the key, or end() if it isn't in the map
+     */
+    template<class K, class H = Hash, class E = KeyEqual, class = typename H::is_transparent,
+            class = typename E::is_transparent>
+    iterator find(const K &k) const
+    {
+        int index = _findSlot(k);
+        if (index == -1)
+        {
+            return end();
+        }
+        return _iteratorAt(index);
     }
 
     /**
@@ -211,16 +744,17 @@ public:
      */
     bool containsKey(const KeyT &k) const
     {
-        using namespace std;
-        int index = std::hash<KeyT>{}(k) & (_capacity - 1);
-        for (auto item:_table[index])
-        {
-            if (item.first == k)
-            {
-                return true;
-            }
-        }
-        return false;
+        return _findSlot(k) != -1;
+    }
+
+    /**
+     * @brief checks whether the key is in the map, by a value of another type (see find)
+     */
+    template<class K, class H = Hash, class E = KeyEqual, class = typename H::is_transparent,
+            class = typename E::is_transparent>
+    bool containsKey(const K &k) const
+    {
+        return _findSlot(k) != -1;
     }
 
     /**
@@ -231,22 +765,20 @@ public:
      */
     ValueT &at(const KeyT &k)
     {
-        using namespace std;
-        int index = _indexInBucket(k);
+        int index = _findSlot(k);
         if (index != -1)
         {
-            return (_table[bucketIndex(k)][index].second);
+            return _item(index).second;
         }
         throw NoKeyFoundException{};
     }
 
     const ValueT &at(const KeyT &k) const
     {
-        using namespace std;
-        int index = _indexInBucket(k);
+        int index = _findSlot(k);
         if (index != -1)
         {
-            return (_table[bucketIndex(k)][index].second);
+            return _item(index).second;
         }
         throw NoKeyFoundException{};
     }
@@ -258,14 +790,13 @@ public:
      */
     bool erase(const KeyT &k)
     {
-        using namespace std;
-        int index = std::hash<KeyT>{}(k) & (_capacity - 1);
-        int indexInV = _indexInBucket(k);
-        if (indexInV != -1)
+        int index = _findSlot(k);
+        if (index != -1)
         {
-            _table[bucketIndex(k)].erase(_table[bucketIndex(k)].begin() + indexInV);
+            _eraseSlot(index);
             _curItems--;
-            _checkIfToResize(1);
+            _migrate(REHASHSTEP);
+            _checkIfToShrink();
             return true;
         }
         return false;
@@ -276,36 +807,62 @@ public:
      */
     double getLoadFactor() const
     {
-        return (double) _curItems / _capacity;
+        return _capacity == 0 ? 0 : (double) _curItems / _capacity;
     }
 
     /**
      * @param k -a given key
-     * @return returns the bucket size of the bucket containing the key k. if k doesn't exist is
-     * error is printed
+     * @return returns the bucket size of the bucket containing the key k - the number of items
+     * in the map that belong to the same bucket (of the table holding k, while a rehash is under
+     * way). if k doesn't exist is error is printed
      */
     int bucketSize(const KeyT &k) const
     {
-        if (containsKey(k))
+        int index = _findSlot(k);
+        if (index == -1)
         {
-            int index = std::hash<KeyT>{}(k) & (_capacity - 1);
-            return _table[index].size();
+            throw NoKeyFoundException{};
         }
-        throw NoKeyFoundException{};
+        const SlotInfo *info = _info;
+        int size = _capacity;
+        if (index >= _capacity)
+        {
+            info = _oldInfo;
+            size = _oldCapacity;
+            index -= _capacity;
+        }
+        int home = (index - info[index].dist) & (size - 1);
+        int count = 0;
+        index = home;
+        for (int dist = 0; info[index].dist != EMPTYSLOT && dist <= info[index].dist; dist++)
+        {
+            if (info[index].dist == dist)
+            {
+                count++;
+            }
+            index = (index + 1) & (size - 1);
+        }
+        return count;
     }
 
     /**
      * @param k -a given key
-     * @return returns the bucket size of the bucket containing the key k. if k doesn't exist is
-     * error is printed
+     * @return returns the bucket index of the bucket containing the key k (in the table holding
+     * it, while a rehash is under way). if k doesn't exist is error is printed
      */
     int bucketIndex(const KeyT &k) const
     {
-        if (containsKey(k))
+        int index = _findSlot(k);
+        if (index == -1)
         {
-            return std::hash<KeyT>{}(k) & (_capacity - 1);
+            throw NoKeyFoundException{};
         }
-        throw NoKeyFoundException{};
+        if (index >= _capacity)
+        {
+            index -= _capacity;
+            return (index - _oldInfo[index].dist) & (_oldCapacity - 1);
+        }
+        return (index - _info[index].dist) & (_capacity - 1);
     }
 
     /**
@@ -313,10 +870,17 @@ public:
      */
     void clear()
     {
-        using namespace std;
         for (int i = 0; i < _capacity; i++)
         {
-            _table[i].clear();
+            if (_info[i].dist != EMPTYSLOT)
+            {
+                _table[i].~pair();
+                _info[i].dist = EMPTYSLOT;
+            }
+        }
+        if (_oldTable != nullptr)
+        {
+            _freeOldTable(true);
         }
         _curItems = 0;
     }
@@ -328,17 +892,7 @@ public:
      */
     const ValueT &operator[](const KeyT &k) const
     {
-        int bIndex = bucketIndex(k);
-        int index = _indexInBucket(k);
-        if (index == -1)
-        {
-            return ValueT();
-        }
-        else
-        {
-            return (_table[bIndex][index].second);
-        }
-
+        return at(k);
     }
 
     /**
@@ -348,35 +902,45 @@ public:
     */
     ValueT &operator[](const KeyT &k)
     {
-        if (containsKey(k))
-        {
-            return at(k);
-        }
-        insert(k, ValueT());
-        return at(k);
+        return try_emplace(k).first->second;
+    }
+
+    ValueT &operator[](KeyT &&k)
+    {
+        return try_emplace(std::move(k)).first->second;
     }
 
     /**
-     * @brief ovveride of operator =.
+     * @brief ovveride of operator =, for both copying and moving (copy and swap): hm is copied
+     * or moved in to the parameter, and then swapped with this map.
      * @param hm - the hashmap that is inserted
      * @return - a reference to a new hashmap which is equal to hm
      */
-    HashMap &operator=(const HashMap &hm)
+    HashMap &operator=(HashMap hm) noexcept
     {
-        if (*this != hm)
-        {
-            _curItems = hm.size();
-            _capacity = hm.capacity();
-            delete[] (_table);
-            _table = new std::vector<std::pair<KeyT, ValueT>>[hm.capacity()];
-            for (int i = 0; i < _capacity; i++)
-            {
-                _table[i] = hm._table[i];
-            }
-        }
+        swap(hm);
         return *this;
     }
 
+    /**
+     * @brief swaps the contents of two hashmaps, without copying any item
+     * @param hm - the hashmap to swap with
+     */
+    void swap(HashMap &hm) noexcept
+    {
+        std::swap(_capacity, hm._capacity);
+        std::swap(_curItems, hm._curItems);
+        std::swap(_table, hm._table);
+        std::swap(_info, hm._info);
+        std::swap(_incremental, hm._incremental);
+        std::swap(_oldCapacity, hm._oldCapacity);
+        std::swap(_oldItems, hm._oldItems);
+        std::swap(_oldNext, hm._oldNext);
+        std::swap(_oldTable, hm._oldTable);
+        std::swap(_oldInfo, hm._oldInfo);
+        std::swap(_alloc, hm._alloc);
+    }
+
     /**
      * @brief overriding operator ==
      * @param hm - a hashmap to check equality to
@@ -390,7 +954,8 @@ public:
         }
         for (auto p: hm)
         {
-            if (!containsKey(p.first) || (p.second != at(p.first)))
+            int index = _findSlot(p.first);
+            if (index == -1 || (p.second != _item(index).second))
             {
                 return false;
             }
@@ -415,13 +980,17 @@ public:
         typedef std::forward_iterator_tag iterator_category;
     private:
         pointer _pointer;
-        std::vector<std::pair<KeyT, ValueT>> *_hmTable;
-        int _curBucket;
+        std::pair<KeyT, ValueT> *_hmTable;
+        SlotInfo *_hmInfo;
+        int _curSlot;
         int _size;
-        int _curIndexInVec;
+        std::pair<KeyT, ValueT> *_oldTable;
+        SlotInfo *_oldInfo;
+        int _oldSize;
 
         /**
-         * @brief find the next item in the map to iterate over
+         * @brief find the next item in the map to iterate over, starting at the current slot.
+         * the slots of the old table come after the ones of the table.
          */
         void _moveToNextItem()
         {
@@ -429,38 +998,38 @@ public:
             {
                 return;
             }
-            while (_curBucket < _size)
+            for (; _curSlot < _size + _oldSize; _curSlot++)
             {
-                if ((int) _hmTable[_curBucket].size() <= _curIndexInVec)
+                if (_curSlot < _size && _hmInfo[_curSlot].dist != EMPTYSLOT)
                 {
-                    _curBucket++;
-                    _curIndexInVec = 0;
+                    _pointer = &(_hmTable[_curSlot]);
+                    return;
                 }
-                else
+                if (_curSlot >= _size && _oldInfo[_curSlot - _size].dist != EMPTYSLOT)
                 {
-
-                    break;
+                    _pointer = &(_oldTable[_curSlot - _size]);
+                    return;
                 }
             }
-            if (_curBucket >= _size)
-            {
-                _pointer = nullptr;
-            }
-            else
-            {
-                _pointer = &(_hmTable[_curBucket][_curIndexInVec]);
-            }
+            _pointer = nullptr;
         }
 
     public:
         /**
          * @brief constructor of the iterator, musrt get hashmap table as input
-         * @param hmTable
+         * @param hmTable - the slots of the hashmap
+         * @param hmInfo - the slot info array of the hashmap, marking the empty slots
+         * @param size - the number of slots
+         * @param slot - the slot to start from
+         * @param oldTable - the slots of the old table of a rehash under way, if any
+         * @param oldInfo - the slot info array of the old table
+         * @param oldSize - the number of slots of the old table
          */
-        iterator(std::vector<std::pair<KeyT, ValueT>> *hmTable = nullptr, pointer point = nullptr,
-                 int
-                 size = 0) :
-                _pointer(point), _hmTable(hmTable), _curBucket(0), _size(size), _curIndexInVec(0)
+        iterator(std::pair<KeyT, ValueT> *hmTable = nullptr, SlotInfo *hmInfo = nullptr,
+                 int size = 0, int slot = 0, std::pair<KeyT, ValueT> *oldTable = nullptr,
+                 SlotInfo *oldInfo = nullptr, int oldSize = 0) :
+                _pointer(nullptr), _hmTable(hmTable), _hmInfo(hmInfo), _curSlot(slot), _size(size),
+                _oldTable(oldTable), _oldInfo(oldInfo), _oldSize(oldSize)
         {
             _moveToNextItem();
         }
@@ -481,7 +1050,7 @@ public:
 
         iterator operator++()
         {
-            _curIndexInVec++;
+            _curSlot++;
             _moveToNextItem();
             iterator i = *this;
             return i;
@@ -489,7 +1058,6 @@ public:
 
         iterator operator++(difference_type)
         {
-            _curIndexInVec++;
             iterator temp = *this;
             ++(*this);
             return temp;
@@ -519,7 +1087,7 @@ public:
      */
     iterator begin() const
     {
-        return iterator(_table, nullptr, capacity());
+        return _iteratorAt(0);
     }
 
     /**
@@ -527,7 +1095,7 @@ public:
      */
     iterator cbegin() const
     {
-        return iterator(_table, nullptr, capacity());
+        return _iteratorAt(0);
     }
 
     /**
@@ -540,38 +1108,60 @@ public:
 };
 
 
-template<class KeyT, class ValueT>
-void HashMap<KeyT, ValueT>::_checkIfToResize(int flag)
+template<class KeyT, class ValueT, class Hash, class KeyEqual, class Alloc>
+void HashMap<KeyT, ValueT, Hash, KeyEqual, Alloc>::_checkIfToShrink()
 {
-    double lf = getLoadFactor();
-    if (lf >= UPPERLF && flag == 0)
+    int newSize = _capacity;
+    while (newSize > 1 && _curItems < newSize * _lowerLoadFactor)
     {
-        _resizeTable(_capacity * MULTIPLYBY);
-        return;
+        newSize /= MULTIPLYBY;
     }
-    while (lf < LOWERLF && flag == 1)
+    if (newSize != _capacity)
     {
-        _resizeTable(_capacity / MULTIPLYBY);
-        lf = getLoadFactor();
+        _resize(newSize);
     }
 }
 
-template<class KeyT, class ValueT>
-void HashMap<KeyT, ValueT>::_resizeTable(int newSize)
+template<class KeyT, class ValueT, class Hash, class KeyEqual, class Alloc>
+void HashMap<KeyT, ValueT, Hash, KeyEqual, Alloc>::_resizeTable(int newSize)
 {
-    using namespace std;
-    auto *newTable = new vector<pair<KeyT, ValueT>>[newSize];
-    for (int vIndex = 0; vIndex < _capacity; vIndex++)
+    _finishRehash();
+    std::pair<KeyT, ValueT> *oldTable = _table;
+    SlotInfo *oldInfo = _info;
+    int oldCapacity = _capacity;
+    _allocTable(newSize, _table, _info);
+    _capacity = newSize;
+    for (int i = 0; i < oldCapacity; i++)
     {
-        for (int pairIndex = 0; pairIndex < (int) _table[vIndex].size(); pairIndex++)
+        if (oldInfo[i].dist != EMPTYSLOT)
         {
-            int index = std::hash<KeyT>{}(_table[vIndex][pairIndex].first) & (newSize - 1);
-            newTable[index].push_back(_table[vIndex][pairIndex]);
+            _placeHashed(oldInfo[i].hash, std::move(oldTable[i]));
+            oldTable[i].~pair();
         }
     }
+    _freeTable(oldCapacity, oldTable, oldInfo, false);
+}
+
+template<class KeyT, class ValueT, class Hash, class KeyEqual, class Alloc>
+void HashMap<KeyT, ValueT, Hash, KeyEqual, Alloc>::_resize(int newSize)
+{
+    if (!_incremental)
+    {
+        _resizeTable(newSize);
+        return;
+    }
+    _finishRehash();
+    _oldTable = _table;
+    _oldInfo = _info;
+    _oldCapacity = _capacity;
+    _oldItems = _curItems;
+    _oldNext = 0;
+    _allocTable(newSize, _table, _info);
     _capacity = newSize;
-    delete[] _table;
-    _table = newTable;
+    if (_oldItems == 0)
+    {
+        _freeOldTable(false);
+    }
 }
 
 
@@ -0,0 +1,97 @@
+//
+// Created by talas on 1/20/2020.
+//
+// a standalone microbenchmark of HashMap: counts the hashes and the key compares (the keys a
+// lookup walks past in its bucket) of every operation, and times it.
+//   g++ -std=c++17 -O2 HashMapBench.cpp -o HashMapBench && ./HashMapBench [keys]
+// to compare with an older HashMap, copy this file next to that HashMap.hpp and build it there.
+//
+
+#include <iostream>
+#include <chrono>
+#include <functional>
+#include <string>
+#include <cstdlib>
+#include "HashMap.hpp"
+
+#define BENCHKEYS 100000
+#define BENCHSTRIDE 7919
+
+/**
+ * @brief an int key that counts the times it is hashed and compared
+ */
+struct BenchKey
+{
+    int value;
+
+    static long hashes;
+    static long compares;
+
+    bool operator==(const BenchKey &rhs) const
+    {
+        compares++;
+        return value == rhs.value;
+    }
+};
+
+long BenchKey::hashes = 0;
+long BenchKey::compares = 0;
+
+namespace std
+{
+    template<>
+    struct hash<BenchKey>
+    {
+        size_t operator()(const BenchKey &key) const
+        {
+            BenchKey::hashes++;
+            return std::hash<int>{}(key.value);
+        }
+    };
+}
+
+/**
+ * @brief runs an operation on every key, and prints its hashes and compares per call
+ * @param name - the name of the operation
+ * @param keys - the number of keys
+ * @param op - the operation, given the key
+ */
+void bench(const std::string &name, int keys, const std::function<void(const BenchKey &)> &op)
+{
+    BenchKey::hashes = 0;
+    BenchKey::compares = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < keys; i++)
+    {
+        // a stride coprime to the number of keys visits them all, out of insertion order
+        op(BenchKey{(int) (((long) i * BENCHSTRIDE) % keys)});
+    }
+    std::chrono::duration<double, std::nano> time = std::chrono::steady_clock::now() - start;
+    std::cout << name << ": " << (double) BenchKey::hashes / keys << " hashes, "
+              << (double) BenchKey::compares / keys << " compares, " << time.count() / keys
+              << " ns per call" << std::endl;
+}
+
+/**
+ * @brief fills a map with the given number of keys, then benchmarks at, operator[] on existing
+ * keys, bucketSize and erase over all of them
+ */
+int main(int argc, char *argv[])
+{
+    int keys = argc > 1 ? std::stoi(argv[1]) : BENCHKEYS;
+    if (keys <= 0 || keys % BENCHSTRIDE == 0)
+    {
+        std::cerr << "Usage: HashMapBench [keys]" << std::endl;
+        return EXIT_FAILURE;
+    }
+    HashMap<BenchKey, int> map;
+    long sum = 0;
+    bench("insert", keys, [&](const BenchKey &k) { map.insert(k, k.value); });
+    bench("at", keys, [&](const BenchKey &k) { sum += map.at(k); });
+    bench("operator[]", keys, [&](const BenchKey &k) { sum += map[k]; });
+    bench("bucketSize", keys, [&](const BenchKey &k) { sum += map.bucketSize(k); });
+    bench("erase", keys, [&](const BenchKey &k) { sum += map.erase(k); });
+    // keeps the lookups from being optimized away
+    std::cout << "checksum " << sum << std::endl;
+    return EXIT_SUCCESS;
+}
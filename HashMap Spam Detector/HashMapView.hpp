@@ -0,0 +1,351 @@
+//
+// Created by talas on 1/27/2020.
+//
+
+#ifndef CPPEX3_HASHMAPVIEW_HPP
+#define CPPEX3_HASHMAPVIEW_HPP
+#define SNAPSHOTMAGIC "SPAMSNAP"
+#define SNAPSHOTVERSION 1
+#define SNAPSHOTORDER 0x01020304u
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <utility>
+#include <fstream>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include "HashMap.hpp"
+#include "HashPolicies.hpp"
+
+/**
+ * @brief the header of a snapshot - a HashMap with std::string keys, saved as an image that can
+ * be used straight from memory (a mapped file) with no parsing. the header is followed by the
+ * slots of a robin hood table (see HashMap), at slotsOffset, and by all the keys one after the
+ * other, at keysOffset. everything in the image is referred to by its offset, not by a pointer,
+ * and is stored in the byte order of the machine that made it (checked through order).
+ */
+struct SnapshotHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t order;
+    uint32_t valueSize;
+    uint32_t capacity;
+    uint64_t count;
+    uint64_t slotsOffset;
+    uint64_t keysOffset;
+    uint64_t keysSize;
+};
+
+/**
+ * @brief a slot of the table of a snapshot. dist is the distance of the item from its bucket,
+ * EMPTYSLOT for an empty slot, and the key is keyLength bytes at keyOffset of the keys.
+ * @tparam ValueT - the values in the map, a trivially copyable type
+ */
+template<class ValueT>
+struct SnapshotSlot
+{
+    uint64_t keyOffset;
+    uint32_t keyLength;
+    int32_t dist;
+    ValueT value;
+};
+
+/**
+ * @brief a read only view of a snapshot of a HashMap with std::string keys (see SnapshotHeader),
+ * lying in a buffer it doesn't own. the keys are hashed with FastStringHash, whose result doesn't
+ * change between runs, and are looked up as std::string_view.
+ * @tparam ValueT - the values in the map, a trivially copyable type
+ */
+template<class ValueT>
+class HashMapView
+{
+    static_assert(std::is_trivially_copyable<ValueT>::value, "values are stored as bytes");
+
+private:
+    const SnapshotHeader *_header;
+    const SnapshotSlot<ValueT> *_slots;
+    const char *_keys;
+
+    /**
+     * @return the key of a full slot
+     */
+    std::string_view _key(const SnapshotSlot<ValueT> &slot) const
+    {
+        uint64_t keysSize = _header->keysSize;
+        if (slot.keyOffset > keysSize || slot.keyLength > keysSize - slot.keyOffset)
+        {
+            return std::string_view();
+        }
+        return std::string_view(_keys + slot.keyOffset, slot.keyLength);
+    }
+
+public:
+    class iterator;
+
+    /**
+     * @brief constructor, of a view of a buffer which is assumed to be a valid snapshot (see
+     * isSnapshot). the buffer must outlive the view.
+     * @param data - the buffer, aligned to 8 bytes
+     */
+    explicit HashMapView(const char *data) :
+            _header(reinterpret_cast<const SnapshotHeader *>(data)),
+            _slots(reinterpret_cast<const SnapshotSlot<ValueT> *>(data + _header->slotsOffset)),
+            _keys(data + _header->keysOffset)
+    {
+    }
+
+    /**
+     * @brief checks that a buffer holds a snapshot of this version, made on a machine like this
+     * one, for this type of values, and that the table and the keys it has fit in the buffer.
+     * @param data - the buffer
+     * @param size - the size of the buffer
+     * @return true if so, false otherwise
+     */
+    static bool isSnapshot(const char *data, size_t size)
+    {
+        if (size < sizeof(SnapshotHeader) || reinterpret_cast<uintptr_t>(data) % 8 != 0)
+        {
+            return false;
+        }
+        auto header = reinterpret_cast<const SnapshotHeader *>(data);
+        uint64_t capacity = header->capacity;
+        return memcmp(header->magic, SNAPSHOTMAGIC, sizeof(header->magic)) == 0 &&
+               header->version == SNAPSHOTVERSION && header->order == SNAPSHOTORDER &&
+               header->valueSize == sizeof(ValueT) && capacity > 0 &&
+               (capacity & (capacity - 1)) == 0 && header->count < capacity &&
+               header->slotsOffset % alignof(SnapshotSlot<ValueT>) == 0 &&
+               header->slotsOffset <= size &&
+               capacity <= (size - header->slotsOffset) / sizeof(SnapshotSlot<ValueT>) &&
+               header->keysOffset <= size && header->keysSize <= size - header->keysOffset;
+    }
+
+    /**
+     * @brief returning the size (how many items) are in the map
+     */
+    int size() const
+    {
+        return (int) _header->count;
+    }
+
+    /**
+     * @brief returning the capacity of the table of the map
+     */
+    int capacity() const
+    {
+        return (int) _header->capacity;
+    }
+
+    /**
+     * @brief checks if the map is empty
+     */
+    bool empty() const
+    {
+        return _header->count == 0;
+    }
+
+    /**
+     * @brief looks up a key in the map
+     * @param k - the key
+     * @return - an iterator to the item of the key, or end() if it isn't in the map
+     */
+    iterator find(std::string_view k) const
+    {
+        uint32_t mask = _header->capacity - 1;
+        uint32_t index = FastStringHash{}(k) & mask;
+        for (int32_t dist = 0; _slots[index].dist != EMPTYSLOT && dist <= _slots[index].dist &&
+                               (uint32_t) dist <= mask; dist++)
+        {
+            if (_key(_slots[index]) == k)
+            {
+                return iterator(this, index);
+            }
+            index = (index + 1) & mask;
+        }
+        return end();
+    }
+
+    /**
+     * @brief this function checks whether the key is in the map.
+     */
+    bool containsKey(std::string_view k) const
+    {
+        return find(k) != end();
+    }
+
+    /**
+     * @brief this function returns the value of the given key in the map. if the key doesn't
+     * exist throws an error
+     */
+    const ValueT &at(std::string_view k) const
+    {
+        iterator it = find(k);
+        if (it == end())
+        {
+            throw NoKeyFoundException{};
+        }
+        return _slots[it._slot].value;
+    }
+
+    /**
+     * @brief an iterator over the items of the view, as pairs of a key and a value
+     */
+    class iterator
+    {
+        friend class HashMapView;
+
+    private:
+        const HashMapView *_view;
+        uint32_t _slot;
+        std::pair<std::string_view, ValueT> _item;
+
+        /**
+         * @brief find the next item in the map to iterate over, starting at the current slot
+         */
+        void _moveToNextItem()
+        {
+            while (_slot < _view->_header->capacity && _view->_slots[_slot].dist == EMPTYSLOT)
+            {
+                _slot++;
+            }
+            if (_slot < _view->_header->capacity)
+            {
+                _item = {_view->_key(_view->_slots[_slot]), _view->_slots[_slot].value};
+            }
+        }
+
+    public:
+        /**
+         * @brief constructor
+         * @param view - the view
+         * @param slot - the slot to start from
+         */
+        iterator(const HashMapView *view, uint32_t slot) : _view(view), _slot(slot), _item()
+        {
+            _moveToNextItem();
+        }
+
+        const std::pair<std::string_view, ValueT> &operator*() const
+        {
+            return _item;
+        }
+
+        const std::pair<std::string_view, ValueT> *operator->() const
+        {
+            return &_item;
+        }
+
+        iterator &operator++()
+        {
+            _slot++;
+            _moveToNextItem();
+            return *this;
+        }
+
+        bool operator==(iterator const &rhs) const
+        {
+            return _slot == rhs._slot;
+        }
+
+        bool operator!=(iterator const &rhs) const
+        {
+            return _slot != rhs._slot;
+        }
+    };
+
+    /**
+     * @brief returns an iterator that points to the start of the map
+     */
+    iterator begin() const
+    {
+        return iterator(this, 0);
+    }
+
+    /**
+     * @brief returns an iterator ponting to the end of the map
+     */
+    iterator end() const
+    {
+        return iterator(this, _header->capacity);
+    }
+};
+
+/**
+ * @brief saves a map with std::string keys as a snapshot (see SnapshotHeader) that a
+ * HashMapView can be laid on. the table is built anew, hashed with FastStringHash. the slots are
+ * zeroed and then only moved with memcpy, so their padding is written as zeros and the same map
+ * always gives the same file.
+ * @param map - the map, of any hash and equality policies
+ * @param path - the file to save the snapshot to
+ * @return true if the snapshot was saved, false otherwise
+ */
+template<class Map>
+bool writeSnapshot(const Map &map, const std::string &path)
+{
+    typedef std::decay_t<decltype(map.begin()->second)> ValueT;
+    static_assert(std::is_trivially_copyable<ValueT>::value, "values are stored as bytes");
+    uint32_t capacity = 1;
+    while (map.size() >= capacity * UPPERLF)
+    {
+        capacity *= MULTIPLYBY;
+    }
+    std::vector<SnapshotSlot<ValueT>> slots(capacity);
+    memset(slots.data(), 0, slots.size() * sizeof(SnapshotSlot<ValueT>));
+    for (auto &slot : slots)
+    {
+        slot.dist = EMPTYSLOT;
+    }
+    std::string keys;
+    SnapshotSlot<ValueT> item, swapped;
+    memset(&item, 0, sizeof(item));
+    for (const auto &p : map)
+    {
+        item.keyOffset = keys.size();
+        item.keyLength = (uint32_t) p.first.size();
+        item.dist = 0;
+        item.value = p.second;
+        keys.append(p.first.data(), p.first.size());
+        uint32_t index = FastStringHash{}(std::string_view(p.first)) & (capacity - 1);
+        for (;; item.dist++)
+        {
+            if (slots[index].dist == EMPTYSLOT)
+            {
+                memcpy(&slots[index], &item, sizeof(item));
+                break;
+            }
+            if (slots[index].dist < item.dist)
+            {
+                memcpy(&swapped, &slots[index], sizeof(item));
+                memcpy(&slots[index], &item, sizeof(item));
+                memcpy(&item, &swapped, sizeof(item));
+            }
+            index = (index + 1) & (capacity - 1);
+        }
+    }
+
+    SnapshotHeader header{};
+    memcpy(header.magic, SNAPSHOTMAGIC, sizeof(header.magic));
+    header.version = SNAPSHOTVERSION;
+    header.order = SNAPSHOTORDER;
+    header.valueSize = sizeof(ValueT);
+    header.capacity = capacity;
+    header.count = map.size();
+    uint64_t align = alignof(SnapshotSlot<ValueT>);
+    header.slotsOffset = (sizeof(header) + align - 1) / align * align;
+    header.keysOffset = header.slotsOffset + slots.size() * sizeof(SnapshotSlot<ValueT>);
+    header.keysSize = keys.size();
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    std::string padding(header.slotsOffset - sizeof(header), '\0');
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    out.write(padding.data(), padding.size());
+    out.write(reinterpret_cast<const char *>(slots.data()),
+              slots.size() * sizeof(SnapshotSlot<ValueT>));
+    out.write(keys.data(), keys.size());
+    out.close();
+    return !out.fail();
+}
+
+#endif //CPPEX3_HASHMAPVIEW_HPP
@@ -0,0 +1,142 @@
+//
+// Created by talas on 1/25/2020.
+//
+
+#ifndef CPPEX3_HASHPOLICIES_HPP
+#define CPPEX3_HASHPOLICIES_HPP
+
+#include <string>
+#include <string_view>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+
+/**
+ * @brief a transparent hash of strings: std::string, std::string_view and char * all hash
+ * the same (through std::hash<std::string_view>), so a HashMap with std::string keys can be
+ * looked up with any of them without building a std::string.
+ */
+struct StringHash
+{
+    typedef void is_transparent;
+
+    size_t operator()(std::string_view str) const
+    {
+        return std::hash<std::string_view>{}(str);
+    }
+};
+
+/**
+ * @brief a fast non cryptographic transparent hash of strings, after wyhash: the text is read
+ * 8 or 16 bytes at a time, and the words are mixed by a 64 x 64 -> 128 bit multiplication
+ * folded back to 64 bits. short strings are read with a couple of overlapping loads and no
+ * loop at all.
+ */
+struct FastStringHash
+{
+    typedef void is_transparent;
+
+    size_t operator()(std::string_view str) const
+    {
+        const uint64_t secret[4] = {0xa0761d6478bd642full, 0xe7037ed1a0b428dbull,
+                                    0x8ebc6af09c88c6e3ull, 0x589965cc75374cc3ull};
+        const char *p = str.data();
+        size_t len = str.size();
+        uint64_t seed = _mix(secret[0], secret[1]);
+        uint64_t a, b;
+        if (len <= 16)
+        {
+            if (len >= 4)
+            {
+                size_t step = (len >> 3) << 2;
+                a = (_read4(p) << 32) | _read4(p + step);
+                b = (_read4(p + len - 4) << 32) | _read4(p + len - 4 - step);
+            }
+            else if (len > 0)
+            {
+                a = ((uint64_t) (unsigned char) p[0] << 16) |
+                    ((uint64_t) (unsigned char) p[len >> 1] << 8) | (unsigned char) p[len - 1];
+                b = 0;
+            }
+            else
+            {
+                a = b = 0;
+            }
+        }
+        else
+        {
+            size_t i = len;
+            if (i > 48)
+            {
+                uint64_t see1 = seed, see2 = seed;
+                do
+                {
+                    seed = _mix(_read8(p) ^ secret[1], _read8(p + 8) ^ seed);
+                    see1 = _mix(_read8(p + 16) ^ secret[2], _read8(p + 24) ^ see1);
+                    see2 = _mix(_read8(p + 32) ^ secret[3], _read8(p + 40) ^ see2);
+                    p += 48;
+                    i -= 48;
+                } while (i > 48);
+                seed ^= see1 ^ see2;
+            }
+            while (i > 16)
+            {
+                seed = _mix(_read8(p) ^ secret[1], _read8(p + 8) ^ seed);
+                p += 16;
+                i -= 16;
+            }
+            a = _read8(p + i - 16);
+            b = _read8(p + i - 8);
+        }
+        return _mix(_mix(a ^ secret[1], b ^ seed) ^ secret[0] ^ len, secret[1]);
+    }
+
+private:
+    /**
+     * @return the high and the low halves of the 128 bit product of a and b, xored
+     */
+    static uint64_t _mix(uint64_t a, uint64_t b)
+    {
+#ifdef __SIZEOF_INT128__
+        __uint128_t product = (__uint128_t) a * b;
+        return (uint64_t) product ^ (uint64_t) (product >> 64);
+#else
+        uint64_t product = a * b;
+        return product ^ (product >> 29) ^ ((a ^ (b >> 32)) * 0x9e3779b97f4a7c15ull);
+#endif
+    }
+
+    static uint64_t _read8(const char *p)
+    {
+        uint64_t word;
+        memcpy(&word, p, sizeof(word));
+        return word;
+    }
+
+    static uint64_t _read4(const char *p)
+    {
+        uint32_t word;
+        memcpy(&word, p, sizeof(word));
+        return word;
+    }
+};
+
+/**
+ * @brief a hash of integers that spreads them over all the bits of the result (the murmur3
+ * finalizer). std::hash of an integer is the integer itself, so keys that differ only in
+ * their high bits would all fall in the same bucket of a HashMap, which uses the low bits.
+ */
+struct IntHash
+{
+    size_t operator()(uint64_t x) const
+    {
+        x ^= x >> 33;
+        x *= 0xff51afd7ed558ccdull;
+        x ^= x >> 33;
+        x *= 0xc4ceb9fe1a85ec53ull;
+        x ^= x >> 33;
+        return x;
+    }
+};
+
+#endif //CPPEX3_HASHPOLICIES_HPP
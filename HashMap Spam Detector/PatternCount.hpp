@@ -0,0 +1,222 @@
+//
+// Created by tal.shaked3 on 28/01/2020.
+//
+
+#ifndef CPPEX3_PATTERNCOUNT_HPP
+#define CPPEX3_PATTERNCOUNT_HPP
+#define SCANPHRASES 8
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <utility>
+#include <cstring>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define PATTERNCOUNT_AVX2
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/**
+ * @brief checks whether the pattern appears at an offset of the text whose first and last
+ * bytes are already known to match it
+ */
+inline bool matchesInside(const char *at, std::string_view pattern)
+{
+    return pattern.size() <= 2 || memcmp(at + 1, pattern.data() + 1, pattern.size() - 2) == 0;
+}
+
+/**
+ * @brief counts the appearances of a pattern in a text, overlapping ones included, one offset
+ * at a time
+ * @param text - the text
+ * @param pattern - the pattern, not empty
+ * @param from - the first offset of the text to check
+ * @return the number of appearances, starting at offsets from from to the last one possible
+ */
+inline size_t countFromByBytes(std::string_view text, std::string_view pattern, size_t from)
+{
+    size_t count = 0;
+    size_t last = pattern.size() - 1;
+    for (size_t i = from; i + pattern.size() <= text.size(); i++)
+    {
+        if (text[i] == pattern[0] && text[i + last] == pattern[last] &&
+            matchesInside(text.data() + i, pattern))
+        {
+            count++;
+        }
+    }
+    return count;
+}
+
+#ifdef __SSE2__
+
+/**
+ * @brief counts the appearances of a pattern in a text, as countFromByBytes, with sse2: the
+ * first and the last byte of the pattern are compared at 16 offsets at once, and only the
+ * offsets where both match are compared in full.
+ */
+inline size_t countBySse2(std::string_view text, std::string_view pattern)
+{
+    const __m128i first = _mm_set1_epi8(pattern[0]);
+    const __m128i last = _mm_set1_epi8(pattern[pattern.size() - 1]);
+    size_t count = 0;
+    size_t i = 0;
+    for (; i + pattern.size() - 1 + 16 <= text.size(); i += 16)
+    {
+        const char *at = text.data() + i;
+        __m128i starts = _mm_loadu_si128(reinterpret_cast<const __m128i *>(at));
+        __m128i ends = _mm_loadu_si128(
+                reinterpret_cast<const __m128i *>(at + pattern.size() - 1));
+        auto candidates = (unsigned) _mm_movemask_epi8(
+                _mm_and_si128(_mm_cmpeq_epi8(starts, first), _mm_cmpeq_epi8(ends, last)));
+        for (; candidates != 0; candidates &= candidates - 1)
+        {
+            count += matchesInside(at + __builtin_ctz(candidates), pattern);
+        }
+    }
+    return count + countFromByBytes(text, pattern, i);
+}
+
+#endif
+
+#ifdef PATTERNCOUNT_AVX2
+
+/**
+ * @brief counts the appearances of a pattern in a text with avx2, 32 offsets at a time. see
+ * countBySse2
+ */
+__attribute__((target("avx2")))
+inline size_t countByAvx2(std::string_view text, std::string_view pattern)
+{
+    const __m256i first = _mm256_set1_epi8(pattern[0]);
+    const __m256i last = _mm256_set1_epi8(pattern[pattern.size() - 1]);
+    size_t count = 0;
+    size_t i = 0;
+    for (; i + pattern.size() - 1 + 32 <= text.size(); i += 32)
+    {
+        const char *at = text.data() + i;
+        __m256i starts = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(at));
+        __m256i ends = _mm256_loadu_si256(
+                reinterpret_cast<const __m256i *>(at + pattern.size() - 1));
+        auto candidates = (unsigned) _mm256_movemask_epi8(
+                _mm256_and_si256(_mm256_cmpeq_epi8(starts, first), _mm256_cmpeq_epi8(ends, last)));
+        for (; candidates != 0; candidates &= candidates - 1)
+        {
+            count += matchesInside(at + __builtin_ctz(candidates), pattern);
+        }
+    }
+    return count + countFromByBytes(text, pattern, i);
+}
+
+#endif
+
+/**
+ * @brief counts the appearances of a pattern in a text, by bytes
+ */
+inline size_t countByBytes(std::string_view text, std::string_view pattern)
+{
+    return countFromByBytes(text, pattern, 0);
+}
+
+/**
+ * @return the fastest way to count appearances this cpu supports
+ */
+inline size_t (*chooseCount())(std::string_view, std::string_view)
+{
+#ifdef PATTERNCOUNT_AVX2
+    if (__builtin_cpu_supports("avx2"))
+    {
+        return countByAvx2;
+    }
+#endif
+#ifdef __SSE2__
+    return countBySse2;
+#else
+    return countByBytes;
+#endif
+}
+
+/**
+ * @brief counts the appearances of a pattern in a text, overlapping ones included, up to and
+ * including the last offset it fits at. the widest simd the cpu has is chosen once, at run
+ * time. nothing is allocated.
+ * @param text - the text
+ * @param pattern - the pattern
+ * @return the number of appearances, 0 for an empty pattern
+ */
+inline size_t countOccurrences(std::string_view text, std::string_view pattern)
+{
+    static size_t (*const count)(std::string_view, std::string_view) = chooseCount();
+    if (pattern.empty() || pattern.size() > text.size())
+    {
+        return 0;
+    }
+    return count(text, pattern);
+}
+
+/**
+ * @brief scores a message by counting the appearances of every phrase of the database in it
+ * with countOccurrences, one phrase after the other. for a database of a few phrases this is
+ * faster than building and running an AhoCorasick, and it gives the same score.
+ */
+class PhraseScanner
+{
+private:
+    std::vector<std::pair<std::string, int>> _phrases;
+
+public:
+    /**
+     * @brief constructor
+     * @param db - the map of the phrases (as keys) and their damage (as values), all the phrases
+     * not empty
+     */
+    template<class Map>
+    explicit PhraseScanner(const Map &db)
+    {
+        for (const auto &p : db)
+        {
+            _phrases.emplace_back(std::string(p.first), p.second);
+        }
+    }
+
+    /**
+     * @brief scores a message - sums up the damage of all the appearances of the phrases in it
+     * @param msg - the message
+     * @return the total damage of the message
+     */
+    long score(const std::string &msg) const
+    {
+        long sum = 0;
+        for (const auto &p : _phrases)
+        {
+            sum += (long) countOccurrences(msg, p.first) * p.second;
+        }
+        return sum;
+    }
+
+    /**
+     * @brief decides whether a message scores at least the threshold, stopping after the first
+     * phrase that brings the damage to it
+     * @param msg - the message
+     * @param threshold - the threshold
+     * @return true if score(msg) >= threshold, false otherwise
+     */
+    bool reaches(const std::string &msg, long threshold) const
+    {
+        long sum = 0;
+        for (const auto &p : _phrases)
+        {
+            if (sum >= threshold)
+            {
+                return true;
+            }
+            sum += (long) countOccurrences(msg, p.first) * p.second;
+        }
+        return sum >= threshold;
+    }
+};
+
+#endif //CPPEX3_PATTERNCOUNT_HPP
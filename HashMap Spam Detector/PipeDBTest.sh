@@ -0,0 +1,32 @@
+#!/bin/bash
+#
+# Created by talas on 2/3/2020.
+#
+# checks that a db given through a pipe scores the same as the same db given as a file - as csv
+# and as a snapshot (see --compile).
+#   bash PipeDBTest.sh
+#
+
+cd "$(dirname "$0")" || exit 1
+dir=$(mktemp -d)
+trap 'rm -rf "$dir"' EXIT
+g++ -std=c++17 -O2 -pthread SpamDetector.cpp -o "$dir/SpamDetector" || exit 1
+
+printf 'free money,3\nclick here,2\nwinner,4\n' > "$dir/db.csv"
+printf 'You are a WINNER\nclick here for free money\n' > "$dir/spam.txt"
+printf 'see you tomorrow\n' > "$dir/ham.txt"
+"$dir/SpamDetector" --compile "$dir/db.csv" "$dir/db.snap" || exit 1
+
+failed=0
+for db in db.csv db.snap; do
+    for msg in spam.txt ham.txt; do
+        expected=$("$dir/SpamDetector" "$dir/$db" "$dir/$msg" 3)
+        piped=$("$dir/SpamDetector" <(cat "$dir/$db") "$dir/$msg" 3)
+        if [ "$expected" != "$piped" ]; then
+            echo "FAILED: $db through a pipe with $msg: $piped, expected $expected"
+            failed=1
+        fi
+    done
+done
+[ "$failed" = 0 ] && echo "OK"
+exit $failed
@@ -3,11 +3,148 @@
 //
 #include <iostream>
 #include "HashMap.hpp"
+#include "AhoCorasick.hpp"
+#include "HashPolicies.hpp"
+#include "TokenScorer.hpp"
+#include "HashMapView.hpp"
+#include "PatternCount.hpp"
+#include "Arena.hpp"
+#include "StringKey.hpp"
 #include <string>
 #include <fstream>
-#include<boost/tokenizer.hpp>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <cstring>
+#include <cstdint>
+#include <cctype>
+#include <algorithm>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
 
-typedef boost::tokenizer<boost::char_separator<char>> tokenizer;
+#define DBCHUNK (1 << 20)
+#define SUBSTRINGMODE "substring"
+#define TOKENSMODE "tokens"
+#define COMPILEFLAG "--compile"
+#define STDINBATCH "-"
+#define LISTPREFIX '@'
+#define BATCHSIZE 1024
+#define MAXMESSAGE (1 << 30)
+#define SPAM "SPAM"
+#define NOTSPAM "NOT_SPAM"
+#define INVALIDMSG "INVALID"
+
+/**
+ * @brief the db - a map of phrases to their damage. the phrases are StringKeys, hashed with
+ * FastStringHash, and can be looked up with a std::string_view of the message with no key built
+ * for it. the db is loaded once and only read afterwards, so its table and its long phrases are
+ * all allocated from one Arena, which frees them together.
+ */
+typedef HashMap<StringKey, int, StringKeyHash, StringKeyEqual,
+        ArenaAllocator<std::pair<StringKey, int>>> DBMap;
+
+/**
+ * @brief the contents of a file, mapped to memory for reading. a file that can't be mapped (a
+ * pipe, for example) is read into a buffer instead.
+ */
+class MappedFile
+{
+private:
+    int _fd;
+    void *_map;
+    size_t _size;
+    std::string _buffer;
+
+public:
+    /**
+     * @brief constructor, maps the file
+     * @param path - the path of the file
+     */
+    explicit MappedFile(const char *path) : _fd(open(path, O_RDONLY)), _map(MAP_FAILED), _size(0)
+    {
+        struct stat info{};
+        if (_fd == -1 || fstat(_fd, &info) == -1)
+        {
+            return;
+        }
+        if (S_ISREG(info.st_mode) && info.st_size > 0)
+        {
+            _size = info.st_size;
+            _map = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, _fd, 0);
+            if (_map != MAP_FAILED)
+            {
+                madvise(_map, _size, MADV_SEQUENTIAL);
+                return;
+            }
+        }
+        char block[1 << 16];
+        ssize_t got;
+        while ((got = read(_fd, block, sizeof(block))) > 0)
+        {
+            _buffer.append(block, got);
+        }
+        _size = _buffer.size();
+    }
+
+    MappedFile(const MappedFile &) = delete;
+
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    /**
+     * destructor
+     */
+    ~MappedFile()
+    {
+        if (_map != MAP_FAILED)
+        {
+            munmap(_map, _size);
+        }
+        if (_fd != -1)
+        {
+            close(_fd);
+        }
+    }
+
+    /**
+     * @return true if the file was opened, false otherwise
+     */
+    bool isOpen() const
+    {
+        return _fd != -1;
+    }
+
+    /**
+     * @return the contents of the file
+     */
+    const char *data() const
+    {
+        return _map != MAP_FAILED ? static_cast<const char *>(_map) : _buffer.data();
+    }
+
+    /**
+     * @return the size of the file
+     */
+    size_t size() const
+    {
+        return _size;
+    }
+};
+
+/**
+ * @brief a line of the db, parsed. its phrase is keyLength chars at keyOffset of the phrases of
+ * its chunk (see parseDBChunk).
+ */
+struct DBRow
+{
+    size_t keyOffset;
+    size_t keyLength;
+    int damage;
+    bool hasDamage;
+};
 
 /**
  * @brief this function checks if a string is a valid number. if so returns true, if not returns
@@ -20,30 +157,124 @@ bool checkStringIsValidNum(std::string const &a, int flag);
 
 /**
  * @brief parses the db, given as a string. extracts out of it a hashmap (assuming it is given in
- * a csv format)
+ * a csv format). the file is mapped to memory and split in to chunks of whole lines, which are
+ * parsed in parallel. the rows are then put in a map that is sized for all of them up front, and
+ * the long phrases are interned in a StringPool of the arena.
  * @param filename - the filename of the db
+ * @param arena - the arena to allocate the map from, which must outlive it
  * @param flag - a flag given as 0. if the flag value is changed after the function is called,
  * there was an error while reading the file.
  * @return - the extracted hashmap of the file
  */
-HashMap<std::string, int> processDB(const std::string &filename, int &flag);
+DBMap processDB(const std::string &filename, Arena &arena, int &flag);
 
 /**
- * @brief parses the text file into a string, lowering the letters
+ * @brief parses the db, given as the contents of its file (see processDB)
+ * @param text - the contents of the db
+ * @param len - the size of the contents
+ * @param arena - the arena to allocate the map from, which must outlive it
+ * @param flag - a flag given as 0. if the flag value is changed after the function is called,
+ * there was an error while parsing the db.
+ * @return - the extracted hashmap of the db
+ */
+DBMap parseDB(const char *text, size_t len, Arena &arena, int &flag);
+
+/**
+ * @brief parses the lines of a chunk of the db. every line must be of the form "phrase,damage"
+ * - exactly one comma, with text on both sides of it - and the damage must be valid (see
+ * parseDamage).
+ * @param begin - the start of the chunk, which is the start of a line
+ * @param end - the end of the chunk, which is the end of a line
+ * @param rows - the vector to add the parsed rows to
+ * @param keys - the string to add the phrases of the rows to, lowered, one after the other
+ * @return true if all the lines are valid, false otherwise
+ */
+bool parseDBChunk(const char *begin, const char *end, std::vector<DBRow> &rows,
+                  std::string &keys);
+
+/**
+ * @brief parses the damage of a db row, accepting exactly what checkStringIsValidNum(str, 0)
+ * accepts: a non negative number with no leading zeros, that reads back the same after going
+ * through an int. a single char that is not a digit is accepted as well, with no damage of its
+ * own - the row keeps the damage of the row before it.
+ * @param str - the damage text
+ * @param len - the length of the text
+ * @param row - the row to set the damage of
+ * @return true if the damage is valid, false otherwise
+ */
+bool parseDamage(const char *str, size_t len, DBRow &row);
+
+/**
+ * @brief parses the text file into a string, lowering the letters. the file is mapped to memory
+ * and lowered in one pass straight into the string, so the text is never copied line by line.
+ * every line of the message ends with a '\n', the last one too.
  * @param msgFile - the file containing the message that is needed to parse
  * @param flag - a flag given as 0. if the flag value is changed after the function is called,
  * there was an error while reading the file.
  * @return
  */
-std::string messageParser(char *msgFile, int &flag);
+std::string messageParser(const char *msgFile, int &flag);
+
+/**
+ * @brief makes a message out of a text as messageParser does: lowers its letters, and ends its
+ * last line with a '\n'
+ * @param text - the text
+ * @param len - the length of the text
+ * @return the message
+ */
+std::string toMessage(const char *text, size_t len);
+
+/**
+ * @brief scores the message given to main (or the batch of messages, see scoreBatch) against a
+ * db, and prints the verdict
+ * @param db - the db, a DBMap or a view of a snapshot of one
+ * @param msgPath - the message path given to main
+ * @param tokens - true to match whole words only (see TokenScorer), false to match phrases
+ * anywhere as substrings (see AhoCorasick)
+ * @param threshold - the least score of spam
+ * @return the exit code of the program
+ */
+template<class Map>
+int scoreMessages(const Map &db, const std::string &msgPath, bool tokens, int threshold);
+
+/**
+ * @brief scores many messages against one db, printing a verdict line for every message in
+ * order - SPAM, NOT_SPAM, or INVALID for a message that couldn't be read. the messages are
+ * taken BATCHSIZE at a time, and the messages of a batch are read and scored on all the cores
+ * at once, sharing the db (which is only read).
+ * @param source - the messages: STDINBATCH for a stream of messages in the standard input, each
+ * given as its length in bytes, a '\n' and the message itself; or LISTPREFIX followed by the path
+ * of a file that lists the paths of message files, one in a line.
+ * @param isSpam - decides whether a message (see messageParser) is spam
+ * @return true if all the messages were valid, false otherwise
+ */
+bool scoreBatch(const std::string &source, const std::function<bool(const std::string &)> &isSpam);
+
+/**
+ * @brief reads the next message of a stream of length prefixed messages (see scoreBatch). a
+ * length over MAXMESSAGE is malformed, and the message is read DBCHUNK bytes at a time, so a
+ * length the stream can't back is never allocated up front.
+ * @param in - the stream
+ * @param message - set to the message, as toMessage makes it
+ * @param flag - a flag given as 0. set to -1 if the stream is malformed.
+ * @return true if a message was read, false at the end of the stream or on an error
+ */
+bool readPrefixedMessage(std::istream &in, std::string &message, int &flag);
+
+/**
+ * @brief runs a task for every index in [0, count), on all the cores
+ * @param count - the number of indices
+ * @param task - the task to run
+ */
+void parallelFor(size_t count, const std::function<void(size_t)> &task);
 
 /**
- * @brief this function counts the appearences of a word inside a given text
- * @param word - the word to check
- * @param msg - the whole text
- * @return - the count
+ * @brief lowers the letters of a text into a buffer (which may be the text itself)
+ * @param src - the text
+ * @param len - the length of the text
+ * @param dest - the buffer to write the len lowered chars in to
  */
-int countApInMsg(std::string &word, std::string &msg);
+void lowercaseInto(const char *src, size_t len, char *dest);
 
 /**
  * @brief - recieves text as string, deep copies it, and then lowers the copy's letters
@@ -55,10 +286,32 @@ std::string lowercase(std::string &str);
 int main(int argc, char *argv[])
 {
     using namespace std;
-    using namespace boost;
-    if (argc != 4)
+    // "--compile <database path> <snapshot path>" saves the db as a snapshot, which can then be
+    // given as the database path and is used as is, with no parsing (see HashMapView)
+    if (argc == 4 && string(argv[1]) == COMPILEFLAG)
     {
-        std::cerr << "Usage: SpamDetector <database path> <message path> <threshold>\n";
+        int flag = 0;
+        Arena arena;
+        DBMap hmDB = processDB(argv[2], arena, flag);
+        if (flag == -1)
+        {
+            return EXIT_FAILURE;
+        }
+        if (!writeSnapshot(hmDB, argv[3]))
+        {
+            std::cerr << "Invalid input\n";
+            return EXIT_FAILURE;
+        }
+        return 0;
+    }
+    // the optional last argument selects how phrases are matched: anywhere in the message as
+    // substrings (the default, see AhoCorasick) or as whole words only (see TokenScorer)
+    if ((argc != 4 && argc != 5) ||
+        (argc == 5 && string(argv[4]) != SUBSTRINGMODE && string(argv[4]) != TOKENSMODE))
+    {
+        std::cerr << "Usage: SpamDetector <database path> <message path> <threshold> "
+                     "[" SUBSTRINGMODE "|" TOKENSMODE "]\n"
+                     "       SpamDetector " COMPILEFLAG " <database path> <snapshot path>\n";
         exit(EXIT_FAILURE);
     }
     if (!checkStringIsValidNum(argv[3], 1))
@@ -71,33 +324,26 @@ int main(int argc, char *argv[])
         int threshold;
         int flag = 0;
         sscanf(argv[3], "%d", &threshold);
-        HashMap<string, int> hmDB;
-        string s = argv[1];
-        hmDB = processDB(s, flag);
-        if (flag == -1)
-        {
-            return EXIT_FAILURE;
-        }
-        string message = (messageParser(argv[2], flag));
-        if (flag == -1)
+        bool tokens = argc == 5 && string(argv[4]) == TOKENSMODE;
+        // the db is read once: a pipe can't be read again, so the csv is parsed from the same
+        // contents that were checked for a snapshot
+        MappedFile dbFile(argv[1]);
+        if (!dbFile.isOpen())
         {
+            std::cerr << "Invalid input\n";
             return EXIT_FAILURE;
         }
-        int sum = 0, count, i = 0;
-        for (auto p: hmDB)
+        if (HashMapView<int>::isSnapshot(dbFile.data(), dbFile.size()))
         {
-            i++;
-            count = countApInMsg(p.first, message);
-            sum += (count * p.second);
+            return scoreMessages(HashMapView<int>(dbFile.data()), argv[2], tokens, threshold);
         }
-        if (sum >= threshold)
-        {
-            cout << "SPAM" << endl;
-        }
-        else
+        Arena arena;
+        DBMap hmDB = parseDB(dbFile.data(), dbFile.size(), arena, flag);
+        if (flag == -1)
         {
-            cout << "NOT_SPAM" << endl;
+            return EXIT_FAILURE;
         }
+        return scoreMessages(hmDB, argv[2], tokens, threshold);
     }
     catch (NoKeyFoundException &e)
     {
@@ -110,6 +356,67 @@ int main(int argc, char *argv[])
     return 0;
 }
 
+template<class Map>
+int scoreMessages(const Map &db, const std::string &msgPath, bool tokens, int threshold)
+{
+    using namespace std;
+    // a message path of STDINBATCH or LISTPREFIX<list path> scores many messages
+    bool batch = msgPath == STDINBATCH || (!msgPath.empty() && msgPath[0] == LISTPREFIX);
+    string message;
+    if (!batch)
+    {
+        int flag = 0;
+        message = messageParser(msgPath.c_str(), flag);
+        if (flag == -1)
+        {
+            return EXIT_FAILURE;
+        }
+    }
+    unique_ptr<AhoCorasick> matcher;
+    unique_ptr<TokenScorer<Map>> scorer;
+    unique_ptr<PhraseScanner> scanner;
+    // the scorers stop as soon as the verdict is known, see AhoCorasick::reaches
+    function<bool(const string &)> isSpam;
+    if (tokens)
+    {
+        scorer.reset(new TokenScorer<Map>(db));
+        isSpam = [&scorer, threshold](const string &msg)
+        {
+            return scorer->reaches(msg, threshold);
+        };
+    }
+    else if (db.size() <= SCANPHRASES && !db.containsKey(""))
+    {
+        // a few phrases are counted one by one faster than an automaton is built for them
+        scanner.reset(new PhraseScanner(db));
+        isSpam = [&scanner, threshold](const string &msg)
+        {
+            return scanner->reaches(msg, threshold);
+        };
+    }
+    else
+    {
+        matcher.reset(new AhoCorasick(db));
+        isSpam = [&matcher, threshold](const string &msg)
+        {
+            return matcher->reaches(msg, threshold);
+        };
+    }
+    if (batch)
+    {
+        return scoreBatch(msgPath, isSpam) ? 0 : EXIT_FAILURE;
+    }
+    if (isSpam(message))
+    {
+        cout << SPAM << endl;
+    }
+    else
+    {
+        cout << NOTSPAM << endl;
+    }
+    return 0;
+}
+
 bool checkStringIsValidNum(std::string const &a, int flag)
 {
     int numA = 0;
@@ -129,106 +436,306 @@ bool checkStringIsValidNum(std::string const &a, int flag)
     return false;
 }
 
-HashMap<std::string, int> processDB(const std::string &filename, int &flag)
+DBMap processDB(const std::string &filename, Arena &arena, int &flag)
 {
-    using namespace std;
-    std::ifstream readFile(filename);
-    if (!readFile.is_open())
+    MappedFile file(filename.c_str());
+    if (!file.isOpen())
     {
         std::cerr << "Invalid input\n";
         flag = -1;
-        HashMap<string, int> h;
-        return h;
+        return DBMap(ArenaAllocator<char>(arena));
     }
-    string line;
-    HashMap<std::string, int> hmDB{};
-    vector<string> vectorOfLine;
-    string word;
-    int damage;
-    boost::char_separator<char> sep{","};
-    while (getline(readFile, line))
+    return parseDB(file.data(), file.size(), arena, flag);
+}
+
+DBMap parseDB(const char *text, size_t len, Arena &arena, int &flag)
+{
+    ArenaAllocator<char> alloc(arena);
+    size_t numChunks = std::max(1u, std::thread::hardware_concurrency());
+    numChunks = std::min(numChunks, len / DBCHUNK + 1);
+
+    std::vector<const char *> bounds{text};
+    for (size_t i = 1; i < numChunks; i++)
     {
-        if (line.find_first_of(',') != line.find_last_of(','))
+        const char *from = std::max(bounds.back(), text + len * i / numChunks);
+        auto newline = static_cast<const char *>(memchr(from, '\n', text + len - from));
+        if (newline != nullptr)
         {
-            readFile.close();
-            std::cerr << "Invalid input\n";
-            flag = -1;
-            HashMap<string, int> h;
-            return h;
+            bounds.push_back(newline + 1);
         }
-        tokenizer tok{line, sep};
-        vectorOfLine.assign(tok.begin(), tok.end());
-        if (distance(tok.begin(), tok.end()) != 2)
+    }
+    bounds.push_back(text + len);
+    numChunks = bounds.size() - 1;
+
+    std::vector<std::vector<DBRow>> rows(numChunks);
+    std::vector<std::string> keys(numChunks);
+    std::vector<char> valid(numChunks);
+    std::vector<std::thread> workers;
+    for (size_t i = 1; i < numChunks; i++)
+    {
+        workers.emplace_back([&, i]()
+                             {
+                                 valid[i] = parseDBChunk(bounds[i], bounds[i + 1], rows[i],
+                                                         keys[i]);
+                             });
+    }
+    valid[0] = parseDBChunk(bounds[0], bounds[1], rows[0], keys[0]);
+    for (auto &worker : workers)
+    {
+        worker.join();
+    }
+
+    size_t numRows = 0;
+    for (size_t i = 0; i < numChunks; i++)
+    {
+        if (!valid[i])
         {
-            readFile.close();
             std::cerr << "Invalid input\n";
             flag = -1;
-            HashMap<string, int> h;
-            return h;
+            return DBMap(alloc);
         }
-        if (checkStringIsValidNum(vectorOfLine[1], 0))
+        numRows += rows[i].size();
+    }
+    DBMap hmDB(alloc);
+    hmDB.reserve(numRows);
+    StringPool pool(arena);
+    int damage = 0;
+    for (size_t i = 0; i < numChunks; i++)
+    {
+        for (const DBRow &row : rows[i])
         {
-            sscanf(vectorOfLine[1].c_str(), "%d", &damage);
-            string key = lowercase(vectorOfLine[0]);
-            hmDB[key] = damage;
+            if (row.hasDamage)
+            {
+                damage = row.damage;
+            }
+            hmDB[StringKey(std::string_view(keys[i].data() + row.keyOffset, row.keyLength),
+                           pool)] = damage;
         }
-        else
+        // the phrases are all copied by now, so the chunk is freed while the next ones go in
+        std::string().swap(keys[i]);
+        std::vector<DBRow>().swap(rows[i]);
+    }
+    return hmDB;
+}
+
+bool parseDBChunk(const char *begin, const char *end, std::vector<DBRow> &rows,
+                  std::string &keys)
+{
+    keys.reserve(end - begin);
+    for (const char *line = begin; line < end;)
+    {
+        auto lineEnd = static_cast<const char *>(memchr(line, '\n', end - line));
+        if (lineEnd == nullptr)
         {
-            readFile.close();
-            std::cerr << "Invalid input\n";
-            flag = -1;
-            HashMap<string, int> h;
-            return h;
+            lineEnd = end;
         }
+        auto comma = static_cast<const char *>(memchr(line, ',', lineEnd - line));
+        if (comma == nullptr || comma == line || comma + 1 == lineEnd ||
+            memchr(comma + 1, ',', lineEnd - comma - 1) != nullptr)
+        {
+            return false;
+        }
+        DBRow row{keys.size(), (size_t) (comma - line), 0, false};
+        keys.append(line, comma - line);
+        lowercaseInto(&keys[row.keyOffset], row.keyLength, &keys[row.keyOffset]);
+        if (!parseDamage(comma + 1, lineEnd - comma - 1, row))
+        {
+            return false;
+        }
+        rows.push_back(row);
+        line = lineEnd + 1;
     }
-    readFile.close();
-    return hmDB;
+    return true;
 }
 
-std::string lowercase(std::string &str)
+bool parseDamage(const char *str, size_t len, DBRow &row)
 {
-    std::string word = str;
-    for (auto &c:word)
+    if (len == 1 && (str[0] < '0' || str[0] > '9'))
+    {
+        // sscanf reads nothing, so checkStringIsValidNum sees a 0 of the same length
+        row.hasDamage = false;
+        return true;
+    }
+    if (len > 10 || (str[0] == '0' && len > 1))
+    {
+        return false;
+    }
+    long value = 0;
+    for (size_t i = 0; i < len; i++)
+    {
+        if (str[i] < '0' || str[i] > '9')
+        {
+            return false;
+        }
+        value = value * 10 + (str[i] - '0');
+    }
+    // sscanf stores the number through an int, so larger numbers wrap around
+    auto damage = (int) (uint32_t) value;
+    size_t digits = 1;
+    for (int rest = damage / 10; rest > 0; rest /= 10)
     {
-        c = ::tolower(c);
+        digits++;
     }
+    if (damage < 0 || digits != len)
+    {
+        return false;
+    }
+    row.damage = damage;
+    row.hasDamage = true;
+    return true;
+}
+
+std::string lowercase(std::string &str)
+{
+    std::string word = str;
+    lowercaseInto(word.data(), word.size(), &word[0]);
     return word;
 }
 
+void lowercaseInto(const char *src, size_t len, char *dest)
+{
+    for (size_t i = 0; i < len; i++)
+    {
+        unsigned char c = src[i];
+        dest[i] = (char) ((unsigned char) (c - 'A') < 26 ? c | 0x20 : c);
+    }
+}
 
-std::string messageParser(char *msgFile, int &flag)
+std::string messageParser(const char *msgFile, int &flag)
 {
-    std::ifstream readFile(msgFile);
-    std::string txt, allT;
-    if (!readFile.is_open())
+    MappedFile file(msgFile);
+    if (!file.isOpen())
     {
         std::cerr << "Invalid input\n";
         flag = -1;
-        return txt;
+        return std::string();
     }
-    while (getline(readFile, txt))
+    return toMessage(file.data(), file.size());
+}
+
+std::string toMessage(const char *text, size_t len)
+{
+    std::string message;
+    message.reserve(len + 1);
+    message.resize(len);
+    lowercaseInto(text, len, &message[0]);
+    if (!message.empty() && message.back() != '\n')
     {
-        std::string ltext = lowercase(txt);
-        allT += ltext;
-        allT += "\n";
+        message += '\n';
     }
-    readFile.close();
-    return allT;
+    return message;
 }
 
-int countApInMsg(std::string &word, std::string &msg)
+bool scoreBatch(const std::string &source, const std::function<bool(const std::string &)> &isSpam)
 {
-    int count = 0;
-    int mlen = msg.length();
-    int wlen = word.length();
-    for (int i = 0; i < (mlen - wlen); i++)
+    bool fromStdin = source == STDINBATCH;
+    std::ifstream list;
+    if (!fromStdin)
     {
-        std::string ss = msg.substr(i, wlen);
-        if (word == ss)
+        list.open(source.substr(1));
+        if (!list.is_open())
         {
-            count++;
+            std::cerr << "Invalid input\n";
+            return false;
         }
     }
-    return count;
+    bool allValid = true;
+    int flag = 0;
+    std::vector<std::string> batch;
+    std::vector<int> verdicts;
+    do
+    {
+        batch.clear();
+        std::string item;
+        while (batch.size() < BATCHSIZE &&
+               (fromStdin ? readPrefixedMessage(std::cin, item, flag) : (bool) getline(list, item)))
+        {
+            batch.push_back(std::move(item));
+        }
+        verdicts.assign(batch.size(), -1);
+        parallelFor(batch.size(), [&](size_t i)
+        {
+            int msgFlag = 0;
+            std::string message = fromStdin ? std::move(batch[i]) :
+                                  messageParser(batch[i].c_str(), msgFlag);
+            if (msgFlag != -1)
+            {
+                verdicts[i] = isSpam(message);
+            }
+        });
+        std::string out;
+        for (int verdict : verdicts)
+        {
+            allValid = allValid && verdict != -1;
+            out += verdict == -1 ? INVALIDMSG : verdict ? SPAM : NOTSPAM;
+            out += '\n';
+        }
+        std::cout << out << std::flush;
+    } while (batch.size() == BATCHSIZE);
+    if (flag == -1)
+    {
+        std::cerr << "Invalid input\n";
+        return false;
+    }
+    return allValid;
+}
 
-}
\ No newline at end of file
+bool readPrefixedMessage(std::istream &in, std::string &message, int &flag)
+{
+    in >> std::ws;
+    if (in.peek() == std::char_traits<char>::eof())
+    {
+        return false;
+    }
+    size_t len = 0;
+    int digits = 0;
+    for (; std::isdigit(in.peek()) && len <= MAXMESSAGE; digits++)
+    {
+        len = len * 10 + (in.get() - '0');
+    }
+    if (digits == 0 || len > MAXMESSAGE || in.get() != '\n')
+    {
+        flag = -1;
+        return false;
+    }
+    message.clear();
+    while (message.size() < len)
+    {
+        size_t read = message.size();
+        message.resize(read + std::min(len - read, (size_t) DBCHUNK));
+        if (!in.read(&message[read], message.size() - read))
+        {
+            flag = -1;
+            return false;
+        }
+    }
+    lowercaseInto(message.data(), len, &message[0]);
+    if (!message.empty() && message.back() != '\n')
+    {
+        message += '\n';
+    }
+    return true;
+}
+
+void parallelFor(size_t count, const std::function<void(size_t)> &task)
+{
+    std::atomic<size_t> next(0);
+    auto work = [&]()
+    {
+        for (size_t i = next++; i < count; i = next++)
+        {
+            task(i);
+        }
+    };
+    size_t numThreads = std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()), count);
+    std::vector<std::thread> workers;
+    for (size_t i = 1; i < numThreads; i++)
+    {
+        workers.emplace_back(work);
+    }
+    work();
+    for (auto &worker : workers)
+    {
+        worker.join();
+    }
+}
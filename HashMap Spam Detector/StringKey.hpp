@@ -0,0 +1,210 @@
+//
+// Created by talas on 1/31/2020.
+//
+
+#ifndef CPPEX3_STRINGKEY_HPP
+#define CPPEX3_STRINGKEY_HPP
+#define INLINEKEY 20
+#define KEYPREFIX 4
+
+#include <string>
+#include <string_view>
+#include <cstdint>
+#include <cstring>
+#include "HashMap.hpp"
+#include "HashPolicies.hpp"
+#include "Arena.hpp"
+
+/**
+ * @brief a pool of interned strings: every distinct string is copied in to an Arena once, and
+ * interning it again gives back the same copy. the copies stay valid as long as the arena does,
+ * after the pool itself is gone.
+ */
+class StringPool
+{
+private:
+    Arena &_arena;
+    HashMap<std::string_view, bool, FastStringHash, std::equal_to<>> _strings;
+
+public:
+    /**
+     * @brief constructor
+     * @param arena - the arena to copy the strings in to
+     */
+    explicit StringPool(Arena &arena) : _arena(arena)
+    {
+    }
+
+    /**
+     * @param str - a string
+     * @return the copy of the string in the pool, made now if the pool has none yet
+     */
+    std::string_view intern(std::string_view str)
+    {
+        auto it = _strings.find(str);
+        if (it != _strings.end())
+        {
+            return it->first;
+        }
+        auto copy = static_cast<char *>(_arena.allocate(str.size(), 1));
+        memcpy(copy, str.data(), str.size());
+        std::string_view interned(copy, str.size());
+        _strings.insert(interned, true);
+        return interned;
+    }
+
+    /**
+     * @return the number of distinct strings in the pool
+     */
+    int size() const
+    {
+        return _strings.size();
+    }
+};
+
+/**
+ * @brief a string key of 32 bytes that keeps its FastStringHash with it. a key of up to
+ * INLINEKEY chars is stored inline; a longer one keeps its first KEYPREFIX chars inline,
+ * followed by a pointer to all of its chars in a StringPool. so comparing keys to a lookup
+ * mostly touches nothing but the slot of the key, and a HashMap of these keys never hashes a
+ * key again once it is made - not when it is compared, and not when the table is resized.
+ * a key is immutable, and copying it copies no chars; the pool (or its arena) of a long key must
+ * outlive it. use it with StringKeyHash and StringKeyEqual.
+ */
+class StringKey
+{
+private:
+    size_t _hash;
+    uint32_t _size;
+    char _chars[INLINEKEY];
+
+    /**
+     * @return the chars of a long key, in its pool
+     */
+    const char *_pooled() const
+    {
+        const char *chars;
+        memcpy(&chars, _chars + KEYPREFIX, sizeof(chars));
+        return chars;
+    }
+
+public:
+    /**
+     * @brief constructor
+     * @param str - the chars of the key
+     * @param pool - the pool to intern a long key in
+     */
+    StringKey(std::string_view str, StringPool &pool) :
+            _hash(FastStringHash{}(str)), _size((uint32_t) str.size()), _chars()
+    {
+        if (str.size() <= INLINEKEY)
+        {
+            memcpy(_chars, str.data(), str.size());
+            return;
+        }
+        const char *chars = pool.intern(str).data();
+        memcpy(_chars, str.data(), KEYPREFIX);
+        memcpy(_chars + KEYPREFIX, &chars, sizeof(chars));
+    }
+
+    /**
+     * @return the hash of the key, as FastStringHash gives for its chars
+     */
+    size_t hash() const
+    {
+        return _hash;
+    }
+
+    size_t size() const
+    {
+        return _size;
+    }
+
+    const char *data() const
+    {
+        return _size <= INLINEKEY ? _chars : _pooled();
+    }
+
+    operator std::string_view() const
+    {
+        return std::string_view(data(), _size);
+    }
+
+    /**
+     * @brief compares the key to the chars of a string, by the inline chars first
+     */
+    bool operator==(std::string_view str) const
+    {
+        if (_size != str.size())
+        {
+            return false;
+        }
+        if (_size <= INLINEKEY)
+        {
+            return memcmp(_chars, str.data(), _size) == 0;
+        }
+        return memcmp(_chars, str.data(), KEYPREFIX) == 0 &&
+               memcmp(_pooled() + KEYPREFIX, str.data() + KEYPREFIX, _size - KEYPREFIX) == 0;
+    }
+
+    /**
+     * @brief compares two keys, by their hashes first. two long keys interned in the same pool
+     * are equal exactly when they point to the same chars.
+     */
+    bool operator==(const StringKey &rhs) const
+    {
+        if (_hash != rhs._hash || _size != rhs._size)
+        {
+            return false;
+        }
+        if (_size <= INLINEKEY)
+        {
+            return memcmp(_chars, rhs._chars, _size) == 0;
+        }
+        return _pooled() == rhs._pooled() || memcmp(_pooled(), rhs._pooled(), _size) == 0;
+    }
+
+    bool operator!=(const StringKey &rhs) const
+    {
+        return !(*this == rhs);
+    }
+};
+
+/**
+ * @brief a transparent hash of StringKey, which gives the hash the key keeps, and of strings,
+ * which gives their FastStringHash - the same hash for the same chars
+ */
+struct StringKeyHash
+{
+    typedef void is_transparent;
+
+    size_t operator()(const StringKey &key) const
+    {
+        return key.hash();
+    }
+
+    size_t operator()(std::string_view str) const
+    {
+        return FastStringHash{}(str);
+    }
+};
+
+/**
+ * @brief a transparent equality of StringKey, to another StringKey or to the chars of a string
+ */
+struct StringKeyEqual
+{
+    typedef void is_transparent;
+
+    bool operator()(const StringKey &key, const StringKey &other) const
+    {
+        return key == other;
+    }
+
+    bool operator()(const StringKey &key, std::string_view str) const
+    {
+        return key == str;
+    }
+};
+
+#endif //CPPEX3_STRINGKEY_HPP
@@ -0,0 +1,176 @@
+//
+// Created by tal.shaked3 on 26/01/2020.
+//
+
+#ifndef CPPEX3_TOKENSCORER_HPP
+#define CPPEX3_TOKENSCORER_HPP
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cctype>
+
+/**
+ * @brief scores a message by whole words instead of substrings: the message is split in to
+ * tokens (runs of letters, digits and non ascii bytes) in one pass, and every run of up to as
+ * many tokens as the longest phrase of the database has is looked up in the database as is - a
+ * std::string_view of the message, from the start of its first token to the end of its last.
+ * so a phrase appears wherever its tokens appear in the message with the same separators
+ * between them, and a phrase that starts or ends with a separator never appears. the work is
+ * linear in the length of the message, and doesn't depend on the size of the database.
+ * @tparam Map - the type of the database, a HashMap of phrases to damage that can be looked up
+ * by a std::string_view (with transparent hash and equality)
+ */
+template<class Map>
+class TokenScorer
+{
+private:
+    const Map &_db;
+    int _maxTokens;
+    size_t _maxLength;
+    long _maxDamage;
+
+    /**
+     * @return true if the char is a part of a token, false if it separates tokens
+     */
+    static bool _isTokenChar(unsigned char c)
+    {
+        return c >= 128 || std::isalnum(c);
+    }
+
+    /**
+     * @brief splits a text in to tokens
+     * @param text - the text
+     * @param bounds - set to the start and the end of every token, in order
+     */
+    static void _tokenize(std::string_view text, std::vector<size_t> &bounds)
+    {
+        bounds.clear();
+        size_t i = 0;
+        while (i < text.size())
+        {
+            while (i < text.size() && !_isTokenChar(text[i]))
+            {
+                i++;
+            }
+            if (i == text.size())
+            {
+                break;
+            }
+            bounds.push_back(i);
+            while (i < text.size() && _isTokenChar(text[i]))
+            {
+                i++;
+            }
+            bounds.push_back(i);
+        }
+    }
+
+    /**
+     * @brief scores a message, stopping early if a positive threshold is given (see reaches).
+     * the message is tokenized as it is scored, and every token is looked up with the runs of
+     * tokens that end with it.
+     * @param msg - the message
+     * @param threshold - the threshold, or a non positive number to score the whole message
+     * @return the total damage of the message, or if it stopped early, the damage so far if
+     * it reached the threshold and some smaller number if it can't
+     */
+    long _score(const std::string &msg, long threshold) const
+    {
+        std::vector<size_t> starts(std::max(_maxTokens, 1));
+        long perToken = _maxDamage * _maxTokens;
+        long sum = 0;
+        int seen = 0;
+        size_t len = msg.size();
+        size_t i = 0;
+        while (true)
+        {
+            while (i < len && !_isTokenChar(msg[i]))
+            {
+                i++;
+            }
+            // there are at most (len - i + 1) / 2 tokens left, each ending at most _maxTokens
+            // runs of tokens
+            if (threshold > 0 && (sum >= threshold || perToken == 0 ||
+                                  (long) (len - i + 1) / 2 <= (threshold - sum - 1) / perToken))
+            {
+                return sum;
+            }
+            if (i == len)
+            {
+                return sum;
+            }
+            starts[seen % starts.size()] = i;
+            seen++;
+            while (i < len && _isTokenChar(msg[i]))
+            {
+                i++;
+            }
+            for (int n = 1; n <= _maxTokens && n <= seen; n++)
+            {
+                size_t start = starts[(seen - n) % starts.size()];
+                if (i - start > _maxLength)
+                {
+                    break;
+                }
+                auto it = _db.find(std::string_view(msg.data() + start, i - start));
+                if (it != _db.end())
+                {
+                    sum += it->second;
+                }
+            }
+        }
+    }
+
+public:
+    /**
+     * @brief constructor. the database is kept by reference, and must outlive the scorer.
+     * @param db - the hashmap of the phrases (as keys) and their damage (as values)
+     */
+    explicit TokenScorer(const Map &db) : _db(db), _maxTokens(0), _maxLength(0), _maxDamage(0)
+    {
+        std::vector<size_t> bounds;
+        for (const auto &p : db)
+        {
+            _tokenize(p.first, bounds);
+            _maxTokens = std::max(_maxTokens, (int) bounds.size() / 2);
+            _maxLength = std::max(_maxLength, p.first.size());
+            _maxDamage = std::max(_maxDamage, (long) p.second);
+        }
+    }
+
+    /**
+     * @brief scores a message - sums up the damage of all the appearances of the phrases in it
+     * as whole tokens
+     * @param msg - the message
+     * @return the total damage of the message
+     */
+    long score(const std::string &msg) const
+    {
+        return _score(msg, -1);
+    }
+
+    /**
+     * @brief decides whether a message scores at least the threshold, stopping as soon as the
+     * answer is known: once the damage so far reaches the threshold (the damage of a phrase is
+     * never negative, so it can only grow), or once even the most damage the tokens left could
+     * add - as many of the most damaging phrase as they start runs of tokens - can't reach it.
+     * @param msg - the message
+     * @param threshold - the threshold
+     * @return true if score(msg) >= threshold, false otherwise
+     */
+    bool reaches(const std::string &msg, long threshold) const
+    {
+        return threshold <= 0 || _score(msg, threshold) >= threshold;
+    }
+
+    /**
+     * @return the number of tokens of the longest phrase of the database
+     */
+    int getMaxTokens() const
+    {
+        return _maxTokens;
+    }
+};
+
+#endif //CPPEX3_TOKENSCORER_HPP